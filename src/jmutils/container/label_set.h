@@ -13,6 +13,7 @@
 
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
+#include <absl/container/inlined_vector.h>
 #include <absl/hash/hash.h>
 
 #include "jmutils/container/weak_container.h"
@@ -170,60 +171,6 @@ public:
     const Labels& labels,
     L lambda
   ) {
-    std::vector<absl::flat_hash_map<node_t*, ll_head_t>> nodes_by_depth;
-    absl::flat_hash_set<label_t> labels_set;
-
-    nodes_by_depth.resize(1);
-
-    for (const auto& label : labels) {
-      labels_set.insert(label);
-      auto search = nodes_by_last_label_.find(label);
-      if (search != nodes_by_last_label_.end()) {
-        for (node_t* node: search->second) {
-          if (node->depth > nodes_by_depth.size()) {
-            nodes_by_depth.resize(node->depth);
-          }
-
-          spdlog::trace(
-            "The entry with labels {} has depth {}",
-            node->entry->labels,
-            node->depth
-          );
-
-          auto& ll_head = nodes_by_depth[node->depth-1][node];
-          ll_head.first = std::make_unique<ll_node_t>();
-          ll_head.first->entry = node->entry.get();
-          ll_head.last = ll_head.first.get();
-        }
-      }
-    }
-
-    for (ssize_t i = nodes_by_depth.size()-1; i >= 1; --i) {
-      for (auto& it : nodes_by_depth[i]) {
-        node_t* parent = it.first->parent;
-        spdlog::trace(
-          "Checking label '{}/{}'",
-          parent->label.first,
-          parent->label.second
-        );
-        if (labels_set.contains(parent->label)) {
-          spdlog::trace(
-            "The label '{}/{}' exists in the depth {}",
-            parent->label.first,
-            parent->label.second,
-            i
-          );
-          auto& ll_head = nodes_by_depth[i-1][parent];
-          if (ll_head.first == nullptr) {
-            ll_head = std::move(it.second);
-          } else {
-            ll_head.last->next = std::move(it.second.first);
-            ll_head.last = it.second.last;
-          }
-        }
-      }
-    }
-
     if (root_->entry != nullptr) {
       bool ok = lambda(
         static_cast<const Labels&>(root_->entry->labels),
@@ -232,16 +179,41 @@ public:
       if (!ok) return false;
     }
 
-    for (auto& it : nodes_by_depth[0]) {
-      auto ll_node = it.second.first.get();
-      while (ll_node != nullptr) {
+    // The labels unknown by the set can't be part of any entry
+    absl::InlinedVector<uint64_t, 8> labels_bits((label_id_by_label_.size() + 63) >> 6);
+    bool has_labels = false;
+    for (const auto& label : labels) {
+      if (
+        auto search = label_id_by_label_.find(label);
+        search != label_id_by_label_.end()
+      ) {
+        labels_bits[search->second >> 6] |= 1ull << (search->second & 63);
+        has_labels = true;
+      }
+    }
+    if (!has_labels) return true;
+
+    // The labels of the entries are sorted, so a node is a subset only if
+    // all his ancestors are also a subset of the labels
+    absl::InlinedVector<node_t*, 32> to_visit;
+    push_subset_children(labels_bits, root_.get(), to_visit);
+    while (!to_visit.empty()) {
+      node_t* node = to_visit.back();
+      to_visit.pop_back();
+
+      if (node->entry != nullptr) {
+        spdlog::trace(
+          "The entry with labels {} is a subset",
+          node->entry->labels
+        );
         bool ok = lambda(
-          static_cast<const Labels&>(ll_node->entry->labels),
-          static_cast<T*>(&(ll_node->entry->value))
+          static_cast<const Labels&>(node->entry->labels),
+          static_cast<T*>(&(node->entry->value))
         );
         if (!ok) return false;
-        ll_node = ll_node->next.get();
       }
+
+      push_subset_children(labels_bits, node, to_visit);
     }
 
     return true;
@@ -259,29 +231,11 @@ public:
 
     node->entry = nullptr;
 
-    if (!labels.empty()) {
-      if (
-        auto search = nodes_by_last_label_.find(labels.back());
-        search != nodes_by_last_label_.end()
-      ) {
-        for (size_t i = 0, l = search->second.size(); i < l; ++i) {
-          if (search->second[i] == node) {
-            jmutils::swap_delete(search->second, i);
-            break;
-          }
-        }
-        if (search->second.empty()) {
-          nodes_by_last_label_.erase(search);
-        }
-      } else {
-        assert(false);
-      }
-      while (node->parent != nullptr) {
-        if (node->first_child != nullptr) break;
-        auto child = extract_child(node->parent, node);
-        assert(child != nullptr);
-        node = child->parent;
-      }
+    while (node->parent != nullptr) {
+      if ((node->first_child != nullptr) || (node->entry != nullptr)) break;
+      auto child = extract_child(node->parent, node);
+      assert(child != nullptr);
+      node = child->parent;
     }
 
     return true;
@@ -297,28 +251,21 @@ private:
     T value;
   };
 
+  typedef uint32_t label_id_t;
+
   struct node_t {
-    label_t label;
-    uint16_t depth{0};
+    label_id_t label_id{0};
     node_t* parent{nullptr};
     std::unique_ptr<node_t> first_child{nullptr};
     std::unique_ptr<node_t> next_sibling{nullptr};
     std::unique_ptr<entry_t> entry{nullptr};
   };
 
-  struct ll_node_t {
-    entry_t* entry{nullptr};
-    std::unique_ptr<ll_node_t> next{nullptr};
-  };
-
-  struct ll_head_t {
-    std::unique_ptr<ll_node_t> first{nullptr};
-    ll_node_t* last{nullptr};
-  };
-
   std::unique_ptr<node_t> root_;
-  absl::flat_hash_map<label_t, std::vector<node_t*>> nodes_by_last_label_;
   absl::flat_hash_map<Labels, node_t*> node_by_labels_;
+  // The ids are dense to use them as positions of a bitset and aren't
+  // reused, the number of distinct labels of a document is small
+  absl::flat_hash_map<label_t, label_id_t> label_id_by_label_;
 
   node_t* get_or_build_node(
     const Labels& labels
@@ -332,12 +279,16 @@ private:
 
     auto node = root_.get();
     for (const auto& label : labels) {
-      if (auto search = get_sibling(label, node->first_child.get())) {
+      auto label_id = label_id_by_label_.try_emplace(
+        label,
+        label_id_by_label_.size()
+      ).first->second;
+
+      if (auto search = get_sibling(label_id, node->first_child.get())) {
         node = search;
       } else {
         auto child = std::make_unique<node_t>();
-        child->label = label;
-        child->depth = node->depth+1;
+        child->label_id = label_id;
         child->parent = node;
         child->next_sibling = std::move(node->first_child);
         node->first_child = std::move(child);
@@ -350,23 +301,32 @@ private:
 
     node_by_labels_[labels] = node;
 
-    if (!labels.empty()) {
-      nodes_by_last_label_[labels.back()].push_back(node);
-    }
-
     return node;
   }
 
   node_t* get_sibling(
-    const label_t& label,
+    label_id_t label_id,
     node_t* node
   ) {
-    while ((node != nullptr) && (node->label != label)) {
+    while ((node != nullptr) && (node->label_id != label_id)) {
       node = node->next_sibling.get();
     }
     return node;
   }
 
+  template <typename V>
+  inline void push_subset_children(
+    const absl::InlinedVector<uint64_t, 8>& labels_bits,
+    node_t* node,
+    V& to_visit
+  ) {
+    for (auto child = node->first_child.get(); child != nullptr; child = child->next_sibling.get()) {
+      if (labels_bits[child->label_id >> 6] & (1ull << (child->label_id & 63))) {
+        to_visit.push_back(child);
+      }
+    }
+  }
+
   std::unique_ptr<node_t> extract_child(
     node_t* parent,
     node_t* child
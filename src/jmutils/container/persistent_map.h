@@ -0,0 +1,611 @@
+#ifndef JMUTILS__CONTAINER__PERSISTENT_MAP_H
+#define JMUTILS__CONTAINER__PERSISTENT_MAP_H
+
+#include <absl/hash/hash.h>
+#include <absl/types/span.h>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "jmutils/cow.h"
+
+namespace jmutils
+{
+namespace container
+{
+
+// A hash array mapped trie whose copies share the nodes, a modification only
+// copy the nodes of the path to the modified key that are shared with other
+// maps (the rest are modified in place). A frozen node keeps the metadata of
+// his subtree, so it's only computed again for the modified paths
+template <
+  typename K,
+  typename V,
+  typename M = no_metadata_t,
+  typename Hash = absl::Hash<K>,
+  typename Eq = std::equal_to<K>
+>
+class PersistentMap final
+{
+public:
+  typedef K key_type;
+  typedef V mapped_type;
+  typedef std::pair<const K, V> value_type;
+
+private:
+  static constexpr uint32_t BITS = 5;
+  static constexpr uint32_t MASK = (1 << BITS) - 1;
+  // The nodes with a bigger shift don't have more hash bits, so they store
+  // the collisions in a plain list
+  static constexpr uint32_t MAX_SHIFT = 64;
+  static constexpr size_t MAX_DEPTH = MAX_SHIFT / BITS + 2;
+
+  struct node_t {
+    std::atomic<uint32_t> refcount{1};
+    bool frozen{false};
+    uint32_t datamap{0};
+    uint32_t nodemap{0};
+    M metadata;
+    // Both are sorted by the position in the bitmaps
+    std::vector<value_type> values;
+    std::vector<node_t*> children;
+
+    node_t() {
+    }
+
+    // The copy start without references, not frozen and with a default metadata
+    node_t(const node_t& o)
+      : datamap(o.datamap),
+      nodemap(o.nodemap),
+      values(o.values),
+      children(o.children)
+    {
+    }
+  };
+
+  struct frame_t {
+    node_t* node;
+    // The values go before the children
+    uint32_t pos;
+  };
+
+  template <bool Const>
+  class Iterator final
+  {
+  public:
+    typedef PersistentMap::value_type value_type;
+    typedef std::forward_iterator_tag iterator_category;
+    typedef ptrdiff_t difference_type;
+    typedef std::conditional_t<Const, const value_type*, value_type*> pointer;
+    typedef std::conditional_t<Const, const value_type&, value_type&> reference;
+
+    Iterator() : depth_(0) {
+    }
+
+    reference operator*() const {
+      const auto& f = stack_[depth_-1];
+      return f.node->values[f.pos];
+    }
+
+    pointer operator->() const {
+      return &**this;
+    }
+
+    Iterator& operator++() {
+      ++stack_[depth_-1].pos;
+      settle();
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator o = *this;
+      ++*this;
+      return o;
+    }
+
+    bool operator==(const Iterator& rhs) const {
+      if (depth_ != rhs.depth_) return false;
+      if (depth_ == 0) return true;
+      const auto& a = stack_[depth_-1];
+      const auto& b = rhs.stack_[depth_-1];
+      return (a.node == b.node) && (a.pos == b.pos);
+    }
+
+    bool operator!=(const Iterator& rhs) const {
+      return !(*this == rhs);
+    }
+
+  private:
+    friend class PersistentMap;
+
+    std::array<frame_t, MAX_DEPTH> stack_;
+    size_t depth_;
+
+    void push(node_t* node, uint32_t pos) {
+      assert(depth_ < MAX_DEPTH);
+      stack_[depth_++] = {node, pos};
+    }
+
+    // Move to the first value in the current position or after it, the
+    // mutable iterators only go through not shared nodes
+    void settle() {
+      while (depth_ > 0) {
+        auto& f = stack_[depth_-1];
+        uint32_t num_values = f.node->values.size();
+        if (f.pos < num_values) return;
+
+        uint32_t child_idx = f.pos - num_values;
+        if (child_idx < f.node->children.size()) {
+          auto& child = f.node->children[child_idx];
+          if constexpr (!Const) {
+            make_unique(child);
+          }
+          push(child, 0);
+        } else if (--depth_ > 0) {
+          ++stack_[depth_-1].pos;
+        }
+      }
+    }
+  };
+
+public:
+  typedef Iterator<false> iterator;
+  typedef Iterator<true> const_iterator;
+
+  PersistentMap() noexcept {
+  }
+
+  ~PersistentMap() noexcept {
+    release(root_);
+  }
+
+  PersistentMap(const PersistentMap& o) noexcept
+    : root_(o.root_),
+    size_(o.size_)
+  {
+    acquire(root_);
+  }
+
+  PersistentMap(PersistentMap&& o) noexcept
+    : root_(std::exchange(o.root_, nullptr)),
+    size_(std::exchange(o.size_, 0))
+  {
+  }
+
+  PersistentMap& operator=(const PersistentMap& o) noexcept {
+    if (this != &o) {
+      acquire(o.root_);
+      release(root_);
+      root_ = o.root_;
+      size_ = o.size_;
+    }
+    return *this;
+  }
+
+  PersistentMap& operator=(PersistentMap&& o) noexcept {
+    std::swap(root_, o.root_);
+    std::swap(size_, o.size_);
+    return *this;
+  }
+
+  inline size_t size() const {
+    return size_;
+  }
+
+  inline bool empty() const {
+    return size_ == 0;
+  }
+
+  void clear() {
+    release(root_);
+    root_ = nullptr;
+    size_ = 0;
+  }
+
+  const_iterator begin() const {
+    const_iterator it;
+    if (root_ != nullptr) {
+      it.push(root_, 0);
+      it.settle();
+    }
+    return it;
+  }
+
+  const_iterator end() const {
+    return const_iterator();
+  }
+
+  iterator begin() {
+    iterator it;
+    if (root_ != nullptr) {
+      make_unique(root_);
+      it.push(root_, 0);
+      it.settle();
+    }
+    return it;
+  }
+
+  iterator end() {
+    return iterator();
+  }
+
+  const_iterator find(const K& key) const {
+    const_iterator it;
+    find_path(root_, key, it);
+    return it;
+  }
+
+  // The path to the key is copied if it's shared, since the value
+  // could be modified with the iterator
+  iterator find(const K& key) {
+    iterator it;
+    if (root_ != nullptr) {
+      make_unique(root_);
+    }
+    find_path(root_, key, it);
+    return it;
+  }
+
+  size_t count(const K& key) const {
+    return find(key) == end() ? 0 : 1;
+  }
+
+  V& operator[](const K& key) {
+    return *insert_path(key, []() { return V(); }).first;
+  }
+
+  // Insert the value if the key isn't present yet, returning if it was
+  // inserted (the value is only built in that case)
+  template <typename... Args>
+  bool emplace(const K& key, Args&&... args) {
+    return insert_path(
+      key,
+      [&args...]() { return V(std::forward<Args>(args)...); }
+    ).second;
+  }
+
+  size_t erase(const K& key) {
+    if (count(key) == 0) return 0;
+
+    erase_path(root_, Hash{}(key), 0, key);
+    if (root_->values.empty() && root_->children.empty()) {
+      release(root_);
+      root_ = nullptr;
+    }
+    --size_;
+
+    return 1;
+  }
+
+  void erase(const_iterator it) {
+    K key(it->first);
+    erase(key);
+  }
+
+  void erase(iterator it) {
+    K key(it->first);
+    erase(key);
+  }
+
+  // Freeze the nodes that aren't frozen, the lambda fills the metadata of
+  // a node with his values and the metadata of his children, that are
+  // frozen before it. The metadata of the root is returned
+  template <typename L>
+  M freeze(L lambda) {
+    if (root_ == nullptr) {
+      return call_lambda(lambda, absl::Span<value_type>(), nullptr, 0);
+    }
+    freeze_node(root_, lambda);
+    return root_->metadata;
+  }
+
+  // Like freeze but without modifying the nodes, the metadata of the not
+  // frozen nodes is computed again every time
+  template <typename L>
+  M make_metadata(L lambda) const {
+    if (root_ == nullptr) {
+      return call_lambda(lambda, absl::Span<const value_type>(), nullptr, 0);
+    }
+    return make_node_metadata(root_, lambda);
+  }
+
+  // Call the function with every value except the ones of the frozen nodes
+  // whose metadata is skipped, it's the metadata of the whole subtree
+  template <typename S, typename F>
+  void for_each(S skip, F fn) const {
+    if (root_ != nullptr) {
+      for_each_node(root_, skip, fn);
+    }
+  }
+
+private:
+  node_t* root_{nullptr};
+  size_t size_{0};
+
+  inline static uint32_t fragment(size_t hash, uint32_t shift) {
+    return (hash >> shift) & MASK;
+  }
+
+  inline static uint32_t index(uint32_t bitmap, uint32_t bit) {
+    return __builtin_popcount(bitmap & (bit - 1));
+  }
+
+  inline static void acquire(node_t* node) {
+    if (node != nullptr) {
+      node->refcount.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  static void release(node_t* node) {
+    if (node == nullptr) return;
+    if (node->refcount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      for (auto child : node->children) {
+        release(child);
+      }
+      delete node;
+    }
+  }
+
+  // After this the node is only referenced by the slot and it isn't frozen
+  static node_t* make_unique(node_t*& slot) {
+    if (slot->refcount.load(std::memory_order_acquire) != 1) {
+      auto node = new node_t(*slot);
+      for (auto child : node->children) {
+        acquire(child);
+      }
+      release(slot);
+      slot = node;
+    }
+    slot->frozen = false;
+    return slot;
+  }
+
+  static void insert_value(
+    std::vector<value_type>& values,
+    size_t idx,
+    value_type&& value
+  ) {
+    // The keys are const, so the values are moved to a new vector
+    std::vector<value_type> result;
+    result.reserve(values.size() + 1);
+    for (size_t i = 0; i < idx; ++i) {
+      result.push_back(std::move(values[i]));
+    }
+    result.push_back(std::move(value));
+    for (size_t i = idx, l = values.size(); i < l; ++i) {
+      result.push_back(std::move(values[i]));
+    }
+    values.swap(result);
+  }
+
+  static value_type remove_value(
+    std::vector<value_type>& values,
+    size_t idx
+  ) {
+    value_type value(std::move(values[idx]));
+    std::vector<value_type> result;
+    result.reserve(values.size() - 1);
+    for (size_t i = 0, l = values.size(); i < l; ++i) {
+      if (i != idx) {
+        result.push_back(std::move(values[i]));
+      }
+    }
+    values.swap(result);
+    return value;
+  }
+
+  template <typename I>
+  static void find_path(node_t* node, const K& key, I& it) {
+    size_t hash = Hash{}(key);
+    for (uint32_t shift = 0; node != nullptr; shift += BITS) {
+      if (shift >= MAX_SHIFT) {
+        for (size_t i = 0, l = node->values.size(); i < l; ++i) {
+          if (Eq{}(node->values[i].first, key)) {
+            it.push(node, i);
+            return;
+          }
+        }
+        break;
+      }
+
+      uint32_t bit = 1 << fragment(hash, shift);
+      if (node->datamap & bit) {
+        uint32_t idx = index(node->datamap, bit);
+        if (Eq{}(node->values[idx].first, key)) {
+          it.push(node, idx);
+          return;
+        }
+        break;
+      }
+      if (!(node->nodemap & bit)) break;
+
+      uint32_t idx = index(node->nodemap, bit);
+      it.push(node, node->values.size() + idx);
+      auto& child = node->children[idx];
+      if constexpr (std::is_same_v<I, iterator>) {
+        make_unique(child);
+      }
+      node = child;
+    }
+
+    it.depth_ = 0;
+  }
+
+  template <typename F>
+  std::pair<V*, bool> insert_path(const K& key, F make_value) {
+    size_t hash = Hash{}(key);
+    if (root_ == nullptr) {
+      root_ = new node_t();
+    }
+
+    node_t** slot = &root_;
+    for (uint32_t shift = 0; ; shift += BITS) {
+      node_t* node = make_unique(*slot);
+
+      if (shift >= MAX_SHIFT) {
+        for (auto& it : node->values) {
+          if (Eq{}(it.first, key)) {
+            return std::make_pair(&it.second, false);
+          }
+        }
+        node->values.emplace_back(key, make_value());
+        ++size_;
+        return std::make_pair(&node->values.back().second, true);
+      }
+
+      uint32_t bit = 1 << fragment(hash, shift);
+      if (node->nodemap & bit) {
+        slot = &node->children[index(node->nodemap, bit)];
+        continue;
+      }
+
+      uint32_t value_idx = index(node->datamap, bit);
+      if (!(node->datamap & bit)) {
+        insert_value(node->values, value_idx, value_type(key, make_value()));
+        node->datamap |= bit;
+        ++size_;
+        return std::make_pair(&node->values[value_idx].second, true);
+      }
+
+      if (Eq{}(node->values[value_idx].first, key)) {
+        return std::make_pair(&node->values[value_idx].second, false);
+      }
+
+      // The present value is moved to a new child, the next
+      // iteration will add the new value to it
+      auto child = new node_t();
+      uint32_t child_shift = shift + BITS;
+      if (child_shift < MAX_SHIFT) {
+        auto child_hash = Hash{}(node->values[value_idx].first);
+        child->datamap = 1 << fragment(child_hash, child_shift);
+      }
+      child->values.push_back(remove_value(node->values, value_idx));
+      node->datamap ^= bit;
+
+      uint32_t child_idx = index(node->nodemap, bit);
+      node->children.insert(node->children.begin() + child_idx, child);
+      node->nodemap |= bit;
+      slot = &node->children[child_idx];
+    }
+  }
+
+  // The key must be present, a child that remains with only one value
+  // is replaced by it to keep the trie compact
+  static void erase_path(
+    node_t*& slot,
+    size_t hash,
+    uint32_t shift,
+    const K& key
+  ) {
+    node_t* node = make_unique(slot);
+
+    if (shift >= MAX_SHIFT) {
+      for (size_t i = 0, l = node->values.size(); i < l; ++i) {
+        if (Eq{}(node->values[i].first, key)) {
+          remove_value(node->values, i);
+          return;
+        }
+      }
+      assert(false);
+      return;
+    }
+
+    uint32_t bit = 1 << fragment(hash, shift);
+    if (node->datamap & bit) {
+      remove_value(node->values, index(node->datamap, bit));
+      node->datamap ^= bit;
+      return;
+    }
+
+    assert(node->nodemap & bit);
+    uint32_t child_idx = index(node->nodemap, bit);
+    erase_path(node->children[child_idx], hash, shift + BITS, key);
+
+    auto child = node->children[child_idx];
+    if (child->children.empty() && (child->values.size() == 1)) {
+      insert_value(
+        node->values,
+        index(node->datamap, bit),
+        remove_value(child->values, 0)
+      );
+      node->datamap |= bit;
+      node->children.erase(node->children.begin() + child_idx);
+      node->nodemap ^= bit;
+      release(child);
+    }
+  }
+
+  template <typename T, typename L>
+  static M call_lambda(
+    L& lambda,
+    absl::Span<T> values,
+    const M* const* children,
+    size_t num_children
+  ) {
+    M metadata;
+    lambda(values, absl::Span<const M* const>(children, num_children), metadata);
+    return metadata;
+  }
+
+  template <typename L>
+  static void freeze_node(node_t* node, L& lambda) {
+    if (node->frozen) return;
+
+    std::array<const M*, 1 << BITS> children;
+    for (size_t i = 0, l = node->children.size(); i < l; ++i) {
+      freeze_node(node->children[i], lambda);
+      children[i] = &node->children[i]->metadata;
+    }
+
+    node->metadata = call_lambda(
+      lambda,
+      absl::Span<value_type>(node->values),
+      children.data(),
+      node->children.size()
+    );
+    node->frozen = true;
+  }
+
+  template <typename L>
+  static M make_node_metadata(const node_t* node, L& lambda) {
+    if (node->frozen) return node->metadata;
+
+    std::array<M, 1 << BITS> metadata;
+    std::array<const M*, 1 << BITS> children;
+    for (size_t i = 0, l = node->children.size(); i < l; ++i) {
+      metadata[i] = make_node_metadata(node->children[i], lambda);
+      children[i] = &metadata[i];
+    }
+
+    return call_lambda(
+      lambda,
+      absl::Span<const value_type>(node->values),
+      children.data(),
+      node->children.size()
+    );
+  }
+
+  template <typename S, typename F>
+  static void for_each_node(const node_t* node, S& skip, F& fn) {
+    if (node->frozen && skip(node->metadata)) return;
+
+    for (const auto& it : node->values) {
+      fn(it);
+    }
+    for (auto child : node->children) {
+      for_each_node(child, skip, fn);
+    }
+  }
+};
+
+} /* container */
+} /* jmutils */
+
+#endif
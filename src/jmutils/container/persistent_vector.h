@@ -0,0 +1,460 @@
+#ifndef JMUTILS__CONTAINER__PERSISTENT_VECTOR_H
+#define JMUTILS__CONTAINER__PERSISTENT_VECTOR_H
+
+#include <absl/types/span.h>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "jmutils/cow.h"
+
+namespace jmutils
+{
+namespace container
+{
+
+// A vector stored in a trie of leaves of 32 values with a separated last
+// leaf, the copies share the nodes and a modification only copy the shared
+// nodes of his path, so the append to a copy only copy the last path. The
+// shape of the trie only depends of the size and a frozen node keeps the
+// metadata of his subtree, so it's only computed again for the modified paths
+template <typename T, typename M = no_metadata_t>
+class PersistentVector final
+{
+public:
+  typedef T value_type;
+
+private:
+  static constexpr uint32_t BITS = 5;
+  static constexpr size_t WIDTH = 1 << BITS;
+  static constexpr size_t MASK = WIDTH - 1;
+
+  // The leaves only have values and the rest of nodes only have children
+  struct node_t {
+    std::atomic<uint32_t> refcount{1};
+    bool frozen{false};
+    M metadata;
+    std::vector<T> values;
+    std::vector<node_t*> children;
+
+    node_t() {
+    }
+
+    // The copy start without references, not frozen and with a default metadata
+    node_t(const node_t& o)
+      : values(o.values),
+      children(o.children)
+    {
+    }
+  };
+
+  template <bool Const>
+  class Iterator final
+  {
+  public:
+    typedef T value_type;
+    typedef std::forward_iterator_tag iterator_category;
+    typedef ptrdiff_t difference_type;
+    typedef std::conditional_t<Const, const T*, T*> pointer;
+    typedef std::conditional_t<Const, const T&, T&> reference;
+    typedef std::conditional_t<Const, const PersistentVector*, PersistentVector*> vector_pointer;
+
+    reference operator*() const {
+      return leaf_[idx_ & MASK];
+    }
+
+    pointer operator->() const {
+      return &leaf_[idx_ & MASK];
+    }
+
+    Iterator& operator++() {
+      if ((++idx_ & MASK) == 0) {
+        settle();
+      }
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator o = *this;
+      ++*this;
+      return o;
+    }
+
+    bool operator==(const Iterator& rhs) const {
+      return idx_ == rhs.idx_;
+    }
+
+    bool operator!=(const Iterator& rhs) const {
+      return idx_ != rhs.idx_;
+    }
+
+  private:
+    friend class PersistentVector;
+
+    vector_pointer vector_;
+    size_t idx_;
+    pointer leaf_{nullptr};
+
+    Iterator(vector_pointer vector, size_t idx)
+      : vector_(vector),
+      idx_(idx)
+    {
+      settle();
+    }
+
+    void settle() {
+      if (idx_ < vector_->size_) {
+        leaf_ = vector_->leaf_for(idx_)->values.data();
+      }
+    }
+  };
+
+public:
+  typedef Iterator<false> iterator;
+  typedef Iterator<true> const_iterator;
+
+  PersistentVector() noexcept {
+  }
+
+  ~PersistentVector() noexcept {
+    release(root_);
+    release(tail_);
+  }
+
+  PersistentVector(const PersistentVector& o) noexcept
+    : root_(o.root_),
+    tail_(o.tail_),
+    size_(o.size_),
+    shift_(o.shift_)
+  {
+    acquire(root_);
+    acquire(tail_);
+  }
+
+  PersistentVector(PersistentVector&& o) noexcept
+    : root_(std::exchange(o.root_, nullptr)),
+    tail_(std::exchange(o.tail_, nullptr)),
+    size_(std::exchange(o.size_, 0)),
+    shift_(std::exchange(o.shift_, BITS))
+  {
+  }
+
+  PersistentVector& operator=(const PersistentVector& o) noexcept {
+    if (this != &o) {
+      acquire(o.root_);
+      acquire(o.tail_);
+      release(root_);
+      release(tail_);
+      root_ = o.root_;
+      tail_ = o.tail_;
+      size_ = o.size_;
+      shift_ = o.shift_;
+    }
+    return *this;
+  }
+
+  PersistentVector& operator=(PersistentVector&& o) noexcept {
+    std::swap(root_, o.root_);
+    std::swap(tail_, o.tail_);
+    std::swap(size_, o.size_);
+    std::swap(shift_, o.shift_);
+    return *this;
+  }
+
+  inline size_t size() const {
+    return size_;
+  }
+
+  inline bool empty() const {
+    return size_ == 0;
+  }
+
+  void clear() {
+    release(root_);
+    release(tail_);
+    root_ = nullptr;
+    tail_ = nullptr;
+    size_ = 0;
+    shift_ = BITS;
+  }
+
+  const T& operator[](size_t idx) const {
+    assert(idx < size_);
+    return leaf_for(idx)->values[idx & MASK];
+  }
+
+  // The path to the value is copied if it's shared
+  T& operator[](size_t idx) {
+    assert(idx < size_);
+    return leaf_for(idx)->values[idx & MASK];
+  }
+
+  const T& front() const {
+    return (*this)[0];
+  }
+
+  const T& back() const {
+    return (*this)[size_-1];
+  }
+
+  const_iterator begin() const {
+    return const_iterator(this, 0);
+  }
+
+  const_iterator end() const {
+    return const_iterator(this, size_);
+  }
+
+  iterator begin() {
+    return iterator(this, 0);
+  }
+
+  iterator end() {
+    return iterator(this, size_);
+  }
+
+  void push_back(T value) {
+    if (tail_ == nullptr) {
+      tail_ = new node_t();
+    } else if (size_ - tail_offset() == WIDTH) {
+      push_tail();
+      tail_ = new node_t();
+    }
+
+    make_unique(tail_)->values.push_back(std::move(value));
+    ++size_;
+  }
+
+  // Freeze the nodes that aren't frozen, the lambda fills the metadata of
+  // a node with his values or the metadata of his children, that are
+  // frozen before it. The returned metadata is the one of a node with
+  // the trie and the last leaf like children
+  template <typename L>
+  M freeze(L lambda) {
+    std::array<const M*, 2> children;
+    size_t num_children = 0;
+    if (root_ != nullptr) {
+      freeze_node(root_, lambda);
+      children[num_children++] = &root_->metadata;
+    }
+    if (tail_ != nullptr) {
+      freeze_node(tail_, lambda);
+      children[num_children++] = &tail_->metadata;
+    }
+    return call_lambda(lambda, absl::Span<T>(), children.data(), num_children);
+  }
+
+  // Like freeze but without modifying the nodes, the metadata of the not
+  // frozen nodes is computed again every time
+  template <typename L>
+  M make_metadata(L lambda) const {
+    std::array<M, 2> metadata;
+    std::array<const M*, 2> children;
+    size_t num_children = 0;
+    if (root_ != nullptr) {
+      metadata[num_children] = make_node_metadata(root_, lambda);
+      children[num_children] = &metadata[num_children];
+      ++num_children;
+    }
+    if (tail_ != nullptr) {
+      metadata[num_children] = make_node_metadata(tail_, lambda);
+      children[num_children] = &metadata[num_children];
+      ++num_children;
+    }
+    return call_lambda(lambda, absl::Span<const T>(), children.data(), num_children);
+  }
+
+  // Call the function with every index and value except the ones of the
+  // frozen nodes whose metadata is skipped, it's the metadata of the
+  // whole subtree
+  template <typename S, typename F>
+  void for_each(S skip, F fn) const {
+    if (root_ != nullptr) {
+      for_each_node(root_, shift_, 0, skip, fn);
+    }
+    if (tail_ != nullptr) {
+      for_each_node(tail_, 0, tail_offset(), skip, fn);
+    }
+  }
+
+private:
+  node_t* root_{nullptr};
+  node_t* tail_{nullptr};
+  size_t size_{0};
+  // The shift of the root, the leaves have a zero shift
+  uint32_t shift_{BITS};
+
+  inline size_t tail_offset() const {
+    return size_ < WIDTH ? 0 : ((size_ - 1) >> BITS) << BITS;
+  }
+
+  inline static void acquire(node_t* node) {
+    if (node != nullptr) {
+      node->refcount.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  static void release(node_t* node) {
+    if (node == nullptr) return;
+    if (node->refcount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      for (auto child : node->children) {
+        release(child);
+      }
+      delete node;
+    }
+  }
+
+  // After this the node is only referenced by the slot and it isn't frozen
+  static node_t* make_unique(node_t*& slot) {
+    if (slot->refcount.load(std::memory_order_acquire) != 1) {
+      auto node = new node_t(*slot);
+      for (auto child : node->children) {
+        acquire(child);
+      }
+      release(slot);
+      slot = node;
+    }
+    slot->frozen = false;
+    return slot;
+  }
+
+  const node_t* leaf_for(size_t idx) const {
+    if (idx >= tail_offset()) return tail_;
+
+    const node_t* node = root_;
+    for (uint32_t shift = shift_; shift > 0; shift -= BITS) {
+      node = node->children[(idx >> shift) & MASK];
+    }
+    return node;
+  }
+
+  node_t* leaf_for(size_t idx) {
+    if (idx >= tail_offset()) return make_unique(tail_);
+
+    node_t* node = make_unique(root_);
+    for (uint32_t shift = shift_; shift > 0; shift -= BITS) {
+      node = make_unique(node->children[(idx >> shift) & MASK]);
+    }
+    return node;
+  }
+
+  // Move the full last leaf to the trie
+  void push_tail() {
+    if (root_ == nullptr) {
+      root_ = new node_t();
+      root_->children.push_back(tail_);
+    } else if ((size_ >> BITS) > (size_t(1) << shift_)) {
+      auto root = new node_t();
+      root->children.push_back(root_);
+      root->children.push_back(new_path(shift_, tail_));
+      root_ = root;
+      shift_ += BITS;
+    } else {
+      push_tail(root_, shift_);
+    }
+  }
+
+  void push_tail(node_t*& slot, uint32_t shift) {
+    node_t* node = make_unique(slot);
+    size_t child_idx = ((size_ - 1) >> shift) & MASK;
+    if (shift == BITS) {
+      node->children.push_back(tail_);
+    } else if (child_idx < node->children.size()) {
+      push_tail(node->children[child_idx], shift - BITS);
+    } else {
+      node->children.push_back(new_path(shift - BITS, tail_));
+    }
+  }
+
+  static node_t* new_path(uint32_t shift, node_t* leaf) {
+    if (shift == 0) return leaf;
+    auto node = new node_t();
+    node->children.push_back(new_path(shift - BITS, leaf));
+    return node;
+  }
+
+  template <typename V, typename L>
+  static M call_lambda(
+    L& lambda,
+    absl::Span<V> values,
+    const M* const* children,
+    size_t num_children
+  ) {
+    M metadata;
+    lambda(values, absl::Span<const M* const>(children, num_children), metadata);
+    return metadata;
+  }
+
+  template <typename L>
+  static void freeze_node(node_t* node, L& lambda) {
+    if (node->frozen) return;
+
+    std::array<const M*, WIDTH> children;
+    for (size_t i = 0, l = node->children.size(); i < l; ++i) {
+      freeze_node(node->children[i], lambda);
+      children[i] = &node->children[i]->metadata;
+    }
+
+    node->metadata = call_lambda(
+      lambda,
+      absl::Span<T>(node->values),
+      children.data(),
+      node->children.size()
+    );
+    node->frozen = true;
+  }
+
+  template <typename L>
+  static M make_node_metadata(const node_t* node, L& lambda) {
+    if (node->frozen) return node->metadata;
+
+    std::array<M, WIDTH> metadata;
+    std::array<const M*, WIDTH> children;
+    for (size_t i = 0, l = node->children.size(); i < l; ++i) {
+      metadata[i] = make_node_metadata(node->children[i], lambda);
+      children[i] = &metadata[i];
+    }
+
+    return call_lambda(
+      lambda,
+      absl::Span<const T>(node->values),
+      children.data(),
+      node->children.size()
+    );
+  }
+
+  template <typename S, typename F>
+  static void for_each_node(
+    const node_t* node,
+    uint32_t shift,
+    size_t offset,
+    S& skip,
+    F& fn
+  ) {
+    if (node->frozen && skip(node->metadata)) return;
+
+    for (size_t i = 0, l = node->values.size(); i < l; ++i) {
+      fn(offset + i, node->values[i]);
+    }
+    for (size_t i = 0, l = node->children.size(); i < l; ++i) {
+      for_each_node(
+        node->children[i],
+        shift - BITS,
+        offset + (i << shift),
+        skip,
+        fn
+      );
+    }
+  }
+};
+
+} /* container */
+} /* jmutils */
+
+#endif
@@ -7,7 +7,12 @@
 namespace jmutils
 {
 
-template <typename T>
+struct no_metadata_t {
+};
+
+// The metadata is filled by the freeze lambda and it's only valid while
+// the value is frozen, a mutable copy start with a default metadata
+template <typename T, typename M = no_metadata_t>
 class Cow final
 {
 public:
@@ -67,11 +72,15 @@ public:
     return (payload_ == nullptr) || payload_->frozen;
   }
 
+  inline const M* metadata() const {
+    return payload_ == nullptr ? nullptr : &payload_->metadata;
+  }
+
   template <typename L>
   void freeze(L lambda) {
     if (payload_ != nullptr) {
       if (!payload_->frozen) {
-        lambda(&payload_->value);
+        lambda(&payload_->value, &payload_->metadata);
       }
       payload_->frozen = true;
     }
@@ -81,6 +90,7 @@ private:
   struct payload_t {
     mutable std::atomic<uint32_t> refcount;
     bool frozen{false};
+    M metadata;
     T value;
 
     template <typename... Args>
@@ -0,0 +1,90 @@
+#include "jmutils/epoch.h"
+
+namespace jmutils
+{
+namespace epoch
+{
+
+std::atomic<uint64_t> global_epoch{1};
+
+std::atomic<slot_t*> slots_head{nullptr};
+
+absl::Mutex retired_mutex;
+std::vector<retired_t> retired;
+
+thread_state_t::~thread_state_t() {
+  if (slot != nullptr) {
+    slot->epoch.store(0, std::memory_order_release);
+    slot->in_use.store(false, std::memory_order_release);
+  }
+}
+
+slot_t* acquire_slot() {
+  for (
+    auto slot = slots_head.load(std::memory_order_acquire);
+    slot != nullptr;
+    slot = slot->next
+  ) {
+    bool in_use = false;
+    if (slot->in_use.compare_exchange_strong(in_use, true, std::memory_order_acq_rel)) {
+      return slot;
+    }
+  }
+
+  // The slots are never released since the threads could be reused
+  auto slot = new slot_t;
+  slot->in_use.store(true, std::memory_order_relaxed);
+  slot->next = slots_head.load(std::memory_order_relaxed);
+  while (!slots_head.compare_exchange_weak(slot->next, slot, std::memory_order_acq_rel));
+  return slot;
+}
+
+void retire(void* ptr, void (*deleter)(void*)) {
+  uint64_t epoch = global_epoch.fetch_add(1, std::memory_order_seq_cst);
+
+  retired_mutex.Lock();
+  retired.push_back({epoch, ptr, deleter});
+  retired_mutex.Unlock();
+
+  reclaim();
+}
+
+size_t reclaim() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  uint64_t min_epoch = global_epoch.load(std::memory_order_seq_cst);
+  for (
+    auto slot = slots_head.load(std::memory_order_acquire);
+    slot != nullptr;
+    slot = slot->next
+  ) {
+    uint64_t epoch = slot->epoch.load(std::memory_order_seq_cst);
+    if ((epoch != 0) && (epoch < min_epoch)) {
+      min_epoch = epoch;
+    }
+  }
+
+  std::vector<retired_t> to_release;
+
+  retired_mutex.Lock();
+  for (size_t i = 0; i < retired.size();) {
+    if (retired[i].epoch < min_epoch) {
+      to_release.push_back(retired[i]);
+      retired[i] = retired.back();
+      retired.pop_back();
+    } else {
+      ++i;
+    }
+  }
+  size_t pending = retired.size();
+  retired_mutex.Unlock();
+
+  for (const auto& it : to_release) {
+    it.deleter(it.ptr);
+  }
+
+  return pending;
+}
+
+} /* epoch */
+} /* jmutils */
@@ -0,0 +1,89 @@
+#ifndef JMUTILS__EPOCH_H
+#define JMUTILS__EPOCH_H
+
+#include <absl/synchronization/mutex.h>
+#include <bits/stdint-uintn.h>
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+
+namespace jmutils
+{
+namespace epoch
+{
+
+// Epoch based reclamation. The readers announce the epoch in a slot owned
+// by the thread (in that way they don't share any cache line) while they
+// use the shared data, and the retired data is only released once all the
+// readers that could see it leave.
+
+struct alignas(64) slot_t {
+  std::atomic<uint64_t> epoch{0};
+  std::atomic<bool> in_use{false};
+  slot_t* next{nullptr};
+};
+
+struct thread_state_t {
+  slot_t* slot{nullptr};
+  uint32_t depth{0};
+
+  ~thread_state_t();
+};
+
+struct retired_t {
+  uint64_t epoch;
+  void* ptr;
+  void (*deleter)(void*);
+};
+
+extern std::atomic<uint64_t> global_epoch;
+
+slot_t* acquire_slot();
+
+inline thread_state_t& thread_state() {
+  thread_local static thread_state_t state;
+  return state;
+}
+
+class Guard final
+{
+public:
+  Guard() {
+    auto& state = thread_state();
+    if (state.depth++ == 0) {
+      if (state.slot == nullptr) {
+        state.slot = acquire_slot();
+      }
+      state.slot->epoch.store(
+        global_epoch.load(std::memory_order_relaxed),
+        std::memory_order_relaxed
+      );
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+
+  ~Guard() {
+    auto& state = thread_state();
+    if (--state.depth == 0) {
+      state.slot->epoch.store(0, std::memory_order_release);
+    }
+  }
+
+  Guard(const Guard& o) = delete;
+  Guard(Guard&& o) = delete;
+
+  Guard& operator=(const Guard& o) = delete;
+  Guard& operator=(Guard&& o) = delete;
+};
+
+// The ptr must be unreachable for the new readers before retire it
+void retire(void* ptr, void (*deleter)(void*));
+
+// Release the retired data that can't be used by any reader,
+// returning the number of pending items
+size_t reclaim();
+
+} /* epoch */
+} /* jmutils */
+
+#endif
@@ -5,30 +5,53 @@ namespace jmutils
 namespace string
 {
 
+namespace {
+  constexpr char CODED_VALUE_TO_ASCII_CHAR[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-";
+
+  // Report the changes of the stats of a shard, it must hold the lock
+  void report_stats(pool_context_t* shard, const stats_t& previous, bool force) {
+    if (shard->stats_observer == nullptr) return;
+
+    stats_delta_t delta;
+    delta.num_strings = (int64_t) shard->stats.num_strings - (int64_t) previous.num_strings;
+    delta.num_chunks = (int64_t) shard->stats.num_chunks - (int64_t) previous.num_chunks;
+    delta.reclaimed_bytes = (int64_t) shard->stats.reclaimed_bytes - (int64_t) previous.reclaimed_bytes;
+    delta.used_bytes = (int64_t) shard->stats.used_bytes - (int64_t) previous.used_bytes;
+    shard->stats_observer->on_updated_stats(delta, force);
+  }
+}
+
 InternalString::InternalString() {
   refcount_.store(0);
   size_ = 0;
   hash_ = 0;
-  data_ = nullptr;
+  data_.store(nullptr);
   chunk_ = nullptr;
   next_ = nullptr;
 }
 
 inline std::string InternalString::str() const {
   if (chunk_ != nullptr) {
-    chunk_->mutex_.ReaderLock();
-    auto result = std::string(data_, size_);
-    chunk_->mutex_.ReaderUnlock();
-    return result;
+    epoch::Guard guard;
+    return std::string(data(), size_);
+  }
+  return std::string(data(), size_);
+}
+
+inline void InternalString::copy(char* output) const {
+  if (chunk_ != nullptr) {
+    epoch::Guard guard;
+    memcpy(output, data(), size_);
+  } else {
+    memcpy(output, data(), size_);
   }
-  return std::string(data_, size_);
 }
 
 void InternalString::init(const std::string& str, const char* data, Chunk* chunk) {
   refcount_.store(0);
   size_ = str.size();
   hash_ = std::hash<std::string>{}(str);
-  data_ = data;
+  data_.store(data, std::memory_order_relaxed);
   chunk_ = chunk;
   next_ = nullptr;
 }
@@ -98,107 +121,140 @@ String::~String() noexcept {
 
 std::string String::str() const {
   if (is_small() || (data_ == 0)) {
-    std::string result;
-    result.reserve(10);
+    std::string result(size(), '\0');
+    copy(result.data());
+    return result;
+  }
+
+  return ((InternalString*) data_)->str();
+}
+
+void String::copy(char* output) const {
+  if (is_small() || (data_ == 0)) {
     uint64_t data = data_;
     if (data_ & 2) {
       data >>= 4;
       switch ((data_>>2) & 3) {
         case 2:
-          result += CODED_VALUE_TO_ASCII_CHAR[data & 63];
+          *output++ = CODED_VALUE_TO_ASCII_CHAR[data & 63];
           data >>= 6;
           // fallthrough
         case 1:
-          result += CODED_VALUE_TO_ASCII_CHAR[data & 63];
+          *output++ = CODED_VALUE_TO_ASCII_CHAR[data & 63];
           data >>= 6;
           // fallthrough
         case 0:
-          result += CODED_VALUE_TO_ASCII_CHAR[data & 63];
+          *output++ = CODED_VALUE_TO_ASCII_CHAR[data & 63];
           data >>= 6;
-          result += CODED_VALUE_TO_ASCII_CHAR[data & 63];
+          *output++ = CODED_VALUE_TO_ASCII_CHAR[data & 63];
           data >>= 6;
-          result += CODED_VALUE_TO_ASCII_CHAR[data & 63];
+          *output++ = CODED_VALUE_TO_ASCII_CHAR[data & 63];
           data >>= 6;
-          result += CODED_VALUE_TO_ASCII_CHAR[data & 63];
+          *output++ = CODED_VALUE_TO_ASCII_CHAR[data & 63];
           data >>= 6;
-          result += CODED_VALUE_TO_ASCII_CHAR[data & 63];
+          *output++ = CODED_VALUE_TO_ASCII_CHAR[data & 63];
           data >>= 6;
-          result += CODED_VALUE_TO_ASCII_CHAR[data & 63];
+          *output++ = CODED_VALUE_TO_ASCII_CHAR[data & 63];
           data >>= 6;
-          result += CODED_VALUE_TO_ASCII_CHAR[data & 63];
+          *output++ = CODED_VALUE_TO_ASCII_CHAR[data & 63];
           data >>= 6;
-          result += CODED_VALUE_TO_ASCII_CHAR[data & 63];
+          *output++ = CODED_VALUE_TO_ASCII_CHAR[data & 63];
           break;
       }
     } else {
-      switch ((data_>>2) & 7) {
-        case 7:
-          data >>= 8;
-          result += static_cast<char>(data & 255);
-          // fallthrough
-        case 6:
-          data >>= 8;
-          result += static_cast<char>(data & 255);
-          // fallthrough
-        case 5:
-          data >>= 8;
-          result += static_cast<char>(data & 255);
-          // fallthrough
-        case 4:
-          data >>= 8;
-          result += static_cast<char>(data & 255);
-          // fallthrough
-        case 3:
-          data >>= 8;
-          result += static_cast<char>(data & 255);
-          // fallthrough
-        case 2:
-          data >>= 8;
-          result += static_cast<char>(data & 255);
-          // fallthrough
-        case 1:
-          data >>= 8;
-          result += static_cast<char>(data & 255);
-          break;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+      // The characters are stored in memory order after the header byte
+      data >>= 8;
+      memcpy(output, &data, (data_>>2) & 7);
+#else
+      for (size_t i = 0, l = (data_>>2) & 7; i < l; ++i) {
+        data >>= 8;
+        *output++ = static_cast<char>(data & 255);
       }
+#endif
     }
-    return result;
+    return;
   }
 
-  return ((InternalString*) data_)->str();
+  ((InternalString*) data_)->copy(output);
+}
+
+std::to_chars_result String::to_chars(char* first, char* last) const {
+  size_t s = size();
+  if ((size_t) (last - first) < s) {
+    return {last, std::errc::value_too_large};
+  }
+  copy(first);
+  return {first + s, std::errc()};
+}
+
+PinnedString::PinnedString(const String& s) {
+  if (s.is_small() || (s.data_ == 0)) {
+    s.copy(buffer_);
+    view_ = std::string_view(buffer_, s.size());
+  } else {
+    auto internal_string = (const InternalString*) s.data_;
+    if (internal_string->chunk_ != nullptr) {
+      guard_.emplace();
+    }
+    view_ = std::string_view(internal_string->data(), internal_string->size_);
+  }
 }
 
 
 Pool::Pool()
-  : stats_observer_(nullptr),
-  pool_context_(std::make_shared<pool_context_t>())
+  : stats_observer_(nullptr)
 {
+  for (auto& shard : shards_) {
+    shard = std::make_shared<pool_context_t>();
+  }
 }
 
 Pool::Pool(
   std::unique_ptr<StatsObserver>&& stats_observer
 )
-  : stats_observer_(std::move(stats_observer)),
-  pool_context_(std::make_shared<pool_context_t>())
+  : stats_observer_(std::move(stats_observer))
 {
+  for (auto& shard : shards_) {
+    shard = std::make_shared<pool_context_t>();
+    shard->stats_observer = stats_observer_.get();
+  }
 }
 
 Pool::~Pool() {
-  pool_context_->mutex.Lock();
-  pool_context_->active = false;
+  for (auto& shard : shards_) {
+    // The strings of the set are released without the lock, since the
+    // release of a string could take it
+    absl::flat_hash_set<String> set;
+
+    shard->mutex.Lock();
+    std::swap(set, shard->set);
+    shard->active = false;
+    shard->current_chunk = nullptr;
+    for (auto& chunks : shard->chunks_by_free_space) {
+      chunks.clear();
+    }
 
-  pool_context_->stats.num_strings = 0;
-  pool_context_->stats.num_chunks = 0;
-  pool_context_->stats.reclaimed_bytes = 0;
-  pool_context_->stats.used_bytes = 0;
+    stats_t previous = shard->stats;
+    shard->stats = stats_t();
+    report_stats(shard.get(), previous, false);
+    // The chunks could outlive the pool and its observer
+    shard->stats_observer = nullptr;
+    shard->mutex.Unlock();
+  }
 
   if (stats_observer_ != nullptr) {
-    stats_observer_->on_updated_stats(pool_context_->stats, true);
+    stats_observer_->on_updated_stats(stats_delta_t(), true);
   }
-  pool_context_->mutex.Unlock();
 
-  for (Chunk* chunk : chunks_) {
-    chunk->decrement_refcount();
+  for (auto& shard : shards_) {
+    for (Chunk* chunk : shard->chunks) {
+      chunk->decrement_refcount();
+    }
+    // The large chunks are released with their string or here
+    for (Chunk* chunk : shard->large_chunks) {
+      chunk->decrement_refcount();
+    }
   }
 }
 
@@ -206,108 +262,323 @@ String Pool::add(const std::string& str) {
   InternalString internal_string;
   String s = make_string(str, &internal_string);
   if (!s.is_small()) {
-    pool_context_->mutex.ReaderLock();
-    if (auto search = pool_context_->set.find(s); search != pool_context_->set.end()) {
+    auto& shard = shards_[s.hash() & (POOL_NUM_SHARDS-1)];
+
+    shard->mutex.ReaderLock();
+    if (auto search = shard->set.find(s); search != shard->set.end()) {
       String result = *search;
-      pool_context_->mutex.ReaderUnlock();
+      shard->mutex.ReaderUnlock();
       return result;
     }
-    pool_context_->mutex.ReaderUnlock();
+    shard->mutex.ReaderUnlock();
 
-    pool_context_->mutex.Lock();
-    if (auto search = pool_context_->set.find(s); search != pool_context_->set.end()) {
+    shard->mutex.Lock();
+    if (auto search = shard->set.find(s); search != shard->set.end()) {
       String result = *search;
-      pool_context_->mutex.Unlock();
+      shard->mutex.Unlock();
       return result;
     }
 
-    auto result = store_string(str);
-    pool_context_->set.insert(result);
-    pool_context_->mutex.Unlock();
+    auto result = store_string(shard, str);
+    shard->set.insert(result);
+    shard->mutex.Unlock();
     return result;
   }
 
   return s;
 }
 
-const stats_t& Pool::stats() const {
-  return pool_context_->stats;
+void Pool::add(const std::vector<std::string>& strs, std::vector<String>& result) {
+  result.clear();
+  result.reserve(strs.size());
+
+  std::unique_ptr<InternalString[]> internal_strings(new InternalString[strs.size()]);
+  std::array<std::vector<size_t>, POOL_NUM_SHARDS> idxs_by_shard;
+  for (size_t i = 0, l = strs.size(); i < l; ++i) {
+    result.push_back(make_string(strs[i], &internal_strings[i]));
+    if (!result[i].is_small()) {
+      idxs_by_shard[result[i].hash() & (POOL_NUM_SHARDS-1)].push_back(i);
+    }
+  }
+
+  std::vector<size_t> missing_idxs;
+  for (size_t shard_idx = 0; shard_idx < POOL_NUM_SHARDS; ++shard_idx) {
+    const auto& idxs = idxs_by_shard[shard_idx];
+    if (idxs.empty()) continue;
+
+    auto& shard = shards_[shard_idx];
+    missing_idxs.clear();
+
+    shard->mutex.ReaderLock();
+    for (size_t i : idxs) {
+      if (auto search = shard->set.find(result[i]); search != shard->set.end()) {
+        result[i] = *search;
+      } else {
+        missing_idxs.push_back(i);
+      }
+    }
+    shard->mutex.ReaderUnlock();
+
+    if (missing_idxs.empty()) continue;
+
+    shard->mutex.Lock();
+    for (size_t i : missing_idxs) {
+      // The string could be added by other thread or repeated in the batch
+      if (auto search = shard->set.find(result[i]); search != shard->set.end()) {
+        result[i] = *search;
+      } else {
+        result[i] = store_string(shard, strs[i]);
+        shard->set.insert(result[i]);
+      }
+    }
+    shard->mutex.Unlock();
+  }
+}
+
+stats_t Pool::stats() const {
+  // The shards are read without a lock, so this is only a approximation
+  stats_t result;
+  for (const auto& shard : shards_) {
+    result.num_strings += shard->stats.num_strings;
+    result.num_chunks += shard->stats.num_chunks;
+    result.reclaimed_bytes += shard->stats.reclaimed_bytes;
+    result.used_bytes += shard->stats.used_bytes;
+  }
+  return result;
 }
 
 void Pool::compact() {
   spdlog::trace("Compacting the chunks");
 
-  pool_context_->mutex.Lock();
-  for (Chunk* chunk : chunks_) {
+  for (auto& shard : shards_) {
+    shard->mutex.Lock();
+    stats_t previous = shard->stats;
+    for (Chunk* chunk : shard->chunks) {
+      chunk->compact();
+    }
+    report_stats(shard.get(), previous, false);
+    shard->mutex.Unlock();
+  }
+}
+
+bool Pool::compact(const MonotonicTimePoint& deadline) {
+  // Only the compactions release chunks, so the obtained ones are valid
+  compaction_mutex_.Lock();
+
+  std::vector<std::pair<int64_t, Chunk*>> fragmented_chunks;
+  for (auto& shard : shards_) {
+    shard->mutex.ReaderLock();
+    for (Chunk* chunk : shard->chunks) {
+      int64_t fragmented_size = chunk->fragmented_size_.load(std::memory_order_relaxed);
+      if (
+        (fragmented_size >= CHUNK_MIN_FRAGMENTED_SIZE_TO_COMPACT)
+        || ((fragmented_size > 0) && (fragmented_size == (int64_t) chunk->next_data_))
+      ) {
+        fragmented_chunks.emplace_back(fragmented_size, chunk);
+      }
+    }
+    shard->mutex.ReaderUnlock();
+  }
+
+  std::sort(
+    fragmented_chunks.begin(),
+    fragmented_chunks.end(),
+    [](const auto& lhs, const auto& rhs) {
+      return lhs.first > rhs.first;
+    }
+  );
+
+  spdlog::debug("Compacting {} fragmented chunks", fragmented_chunks.size());
+
+  size_t i = 0;
+  for (size_t l = fragmented_chunks.size(); (i < l) && (monotonic_now() < deadline); ++i) {
+    Chunk* chunk = fragmented_chunks[i].second;
+    // The chunk could be released
+    auto shard = chunk->pool_context_;
+
+    shard->mutex.Lock();
+    stats_t previous = shard->stats;
     chunk->compact();
+    if ((chunk->head_ == nullptr) && (chunk != shard->current_chunk)) {
+      release_chunk(shard, chunk);
+    }
+    report_stats(shard.get(), previous, false);
+    shard->mutex.Unlock();
+  }
+
+  if (stats_observer_ != nullptr) {
+    stats_observer_->on_updated_stats(stats_delta_t(), true);
   }
-  pool_context_->mutex.Unlock();
+
+  compaction_mutex_.Unlock();
+
+  epoch::reclaim();
+
+  return i == fragmented_chunks.size();
 }
 
-const String Pool::store_string(const std::string& str) {
+const String Pool::store_string(
+  const std::shared_ptr<pool_context_t>& shard,
+  const std::string& str
+) {
   spdlog::trace("Adding a new string of size {}", str.size());
-  pool_context_->stats.num_strings += 1;
+  stats_t previous = shard->stats;
+  shard->stats.num_strings += 1;
 
-  size_t idx = 0;
-  size_t end = chunks_.size();
-  while ((idx != end) && (chunks_[idx]->next_data_ + str.size() >= CHUNK_DATA_SIZE)) {
-    ++idx;
+  if (str.size() >= LARGE_STRING_MIN_SIZE) {
+    auto result = new_large_chunk(shard, str.size())->add(str);
+    report_stats(shard.get(), previous, false);
+    return result;
   }
-  if (idx == end) chunks_.push_back(new_chunk());
-
-  auto result = chunks_[idx]->add(str);
 
-  if (stats_observer_ != nullptr) {
-    stats_observer_->on_updated_stats(pool_context_->stats, false);
+  auto chunk = shard->current_chunk;
+  if ((chunk == nullptr) || (chunk->free_space() <= str.size())) {
+    if (chunk != nullptr) {
+      chunk->index_free_space();
+    }
+    chunk = obtain_chunk(shard, str.size());
+    shard->current_chunk = chunk;
   }
 
+  auto result = chunk->add(str);
+  report_stats(shard.get(), previous, false);
+
   return result;
 }
 
-Chunk* Pool::new_chunk() {
+Chunk* Pool::obtain_chunk(const std::shared_ptr<pool_context_t>& shard, size_t size) {
+  // All the chunks of a bin have more free space that the size
+  size_t bin = 0;
+  for (size_t x = size; x; x >>= 1) ++bin;
+
+  for (; bin < CHUNK_FREE_SPACE_BINS; ++bin) {
+    auto& chunks = shard->chunks_by_free_space[bin];
+    if (!chunks.empty()) {
+      auto chunk = chunks.back();
+      chunk->unindex_free_space();
+      return chunk;
+    }
+  }
+
+  shard->chunks.push_back(new_chunk(shard));
+  return shard->chunks.back();
+}
+
+Chunk* Pool::new_chunk(const std::shared_ptr<pool_context_t>& shard) {
   spdlog::trace("Making a new chunk");
-  pool_context_->stats.num_chunks += 1;
-  pool_context_->stats.reclaimed_bytes += CHUNK_DATA_SIZE;
+  shard->stats.num_chunks += 1;
+  shard->stats.reclaimed_bytes += CHUNK_DATA_SIZE;
+
+  void* data = aligned_alloc(8, sizeof(Chunk));
+  assert (data != nullptr);
+  return new (data) Chunk(shard);
+}
+
+void Pool::release_chunk(const std::shared_ptr<pool_context_t>& shard, Chunk* chunk) {
+  spdlog::trace("Releasing the empty chunk {}", (void*)chunk);
+  for (size_t i = 0, l = shard->chunks.size(); i < l; ++i) {
+    if (shard->chunks[i] == chunk) {
+      jmutils::swap_delete(shard->chunks, i);
+      break;
+    }
+  }
+  chunk->unindex_free_space();
+
+  shard->stats.num_chunks -= 1;
+  shard->stats.reclaimed_bytes -= CHUNK_DATA_SIZE;
+
+  chunk->decrement_refcount();
+}
+
+Chunk* Pool::new_large_chunk(const std::shared_ptr<pool_context_t>& shard, size_t size) {
+  spdlog::trace("Making a new large chunk of size {}", size);
+  shard->stats.reclaimed_bytes += size;
 
   void* data = aligned_alloc(8, sizeof(Chunk));
   assert (data != nullptr);
-  return new (data) Chunk(pool_context_);
+  auto chunk = new (data) Chunk(shard, true, size);
+  shard->large_chunks.insert(chunk);
+  return chunk;
+}
+
+void Pool::release_chunk_data(void* data) {
+  delete[] static_cast<char*>(data);
 }
 
 
-Chunk::Chunk(std::shared_ptr<pool_context_t> pool_context) : pool_context_(std::move(pool_context)) {
+Chunk::Chunk(
+  std::shared_ptr<pool_context_t> pool_context,
+  bool large,
+  size_t data_size
+) : pool_context_(std::move(pool_context)) {
   refcount_.store(1);
   next_data_ = 0;
+  large_ = large;
+  free_space_bin_ = CHUNK_WITHOUT_FREE_SPACE_BIN;
+  free_space_idx_ = 0;
   fragmented_size_.store(0);
   head_ = nullptr;
   tail_ = nullptr;
+  data_ = new char[data_size];
+}
+
+Chunk::~Chunk() {
+  delete[] data_;
+}
+
+void Chunk::index_free_space() {
+  uint32_t free_space = this->free_space();
+  if (free_space == 0) return;
+
+  free_space_bin_ = 0;
+  while (free_space >>= 1) ++free_space_bin_;
+
+  auto& chunks = pool_context_->chunks_by_free_space[free_space_bin_];
+  free_space_idx_ = chunks.size();
+  chunks.push_back(this);
+}
+
+void Chunk::unindex_free_space() {
+  if (free_space_bin_ == CHUNK_WITHOUT_FREE_SPACE_BIN) return;
+
+  auto& chunks = pool_context_->chunks_by_free_space[free_space_bin_];
+  chunks[free_space_idx_] = chunks.back();
+  chunks[free_space_idx_]->free_space_idx_ = free_space_idx_;
+  chunks.pop_back();
+
+  free_space_bin_ = CHUNK_WITHOUT_FREE_SPACE_BIN;
 }
 
-void Chunk::released_string(uint32_t size) {
+void Chunk::released_string(size_t size) {
   ssize_t fragmented_size = fragmented_size_.fetch_add(
     size,
     std::memory_order_relaxed
   ) + size;
 
+  // The large strings are released as soon as possible
+  ssize_t limit = large_ ? 0 : (CHUNK_DATA_SIZE>>1);
+
   spdlog::trace(
     "Checking if it's possible compact the chunk (fragmented_size: {}, limit: {})",
     fragmented_size,
-    CHUNK_DATA_SIZE>>1
+    limit
   );
-  if (fragmented_size > (CHUNK_DATA_SIZE>>1)) {
-    if (fragmented_size_.load(std::memory_order_acq_rel) > (CHUNK_DATA_SIZE>>1)) {
-      pool_context_->mutex.Lock();
-      if (pool_context_->active && (fragmented_size_.load(std::memory_order_acq_rel) > (CHUNK_DATA_SIZE>>1))) {
+  if (fragmented_size > limit) {
+    if (fragmented_size_.load(std::memory_order_acq_rel) > limit) {
+      // The compaction of a large chunk could destroy it
+      auto pool_context = pool_context_;
+      pool_context->mutex.Lock();
+      if (pool_context->active && (fragmented_size_.load(std::memory_order_acq_rel) > limit)) {
+        stats_t previous = pool_context->stats;
         compact();
+        report_stats(pool_context.get(), previous, false);
       }
-      pool_context_->mutex.Unlock();
+      pool_context->mutex.Unlock();
     }
   }
 }
 
 String Chunk::add(const std::string& str) {
-  mutex_.Lock();
-
   refcount_.fetch_add(1, std::memory_order_relaxed);
 
   spdlog::trace("Adding a string of size {} in {}", str.size(), (void*)this);
@@ -323,25 +594,25 @@ String Chunk::add(const std::string& str) {
 
   next_data_ += str.size();
   pool_context_->stats.used_bytes += str.size();
-  String result((uint64_t)tail_);
-  mutex_.Unlock();
-
-  return result;
+  return String((uint64_t)tail_);
 }
 
 void Chunk::compact() {
-  mutex_.Lock();
+  if (large_) {
+    compact_large();
+    return;
+  }
 
   spdlog::trace("Compacting the chunk {}", (void*)this);
-  int32_t used_bytes = fragmented_size_.fetch_sub(1073741824, std::memory_order_acq_rel);
-  pool_context_->stats.used_bytes -= used_bytes;
+  int64_t fragmented_size = fragmented_size_.fetch_sub(1073741824, std::memory_order_acq_rel);
+  // The live strings are added again after reallocate them
+  pool_context_->stats.used_bytes -= next_data_;
 
   InternalString fake_head;
   fake_head.next_ = head_;
   InternalString* last = &fake_head;
-  next_data_ = 0;
 
-  spdlog::trace("Reallocating the strings");
+  spdlog::trace("Removing the unused strings");
   for (auto* current = last->next_; last->next_; current = last->next_) {
     if (current->refcount_.load(std::memory_order_acq_rel) == 1) {
       spdlog::trace("Removing the string {}", (void*)current);
@@ -350,54 +621,99 @@ void Chunk::compact() {
       pool_context_->set.erase(String((uint64_t)current));
       pool_context_->stats.num_strings -= 1;
     } else {
-      reallocate(current);
       last = current;
     }
   }
 
   head_ = fake_head.next_;
   tail_ = (last == &fake_head) ? nullptr : last;
+  next_data_ = 0;
+
+  // Without strings nobody could read the data, so it's reused
+  if (head_ != nullptr) {
+    spdlog::trace("Reallocating the strings");
+    char* data = new char[CHUNK_DATA_SIZE];
+    for (auto* current = head_; current != nullptr; current = current->next_) {
+      reallocate(current, data);
+    }
+
+    // The readers could be copying the old data yet
+    std::swap(data, data_);
+    epoch::retire(data, &Pool::release_chunk_data);
+  }
+
+  if (pool_context_->current_chunk != this) {
+    unindex_free_space();
+    index_free_space();
+  }
 
   spdlog::trace("Reallocated the strings");
   pool_context_->stats.used_bytes += next_data_;
-  fragmented_size_.fetch_add(1073741824 - used_bytes, std::memory_order_acq_rel);
+  fragmented_size_.fetch_add(1073741824 - fragmented_size, std::memory_order_acq_rel);
+}
+
+void Chunk::compact_large() {
+  spdlog::trace("Checking the large chunk {}", (void*)this);
+  // Avoid compact it again releasing the string
+  fragmented_size_.fetch_sub(1073741824, std::memory_order_acq_rel);
+
+  InternalString* s = head_;
+  if ((s != nullptr) && (s->refcount_.load(std::memory_order_acquire) == 1)) {
+    spdlog::trace("Removing the large string {}", (void*)s);
+    head_ = tail_ = nullptr;
+    pool_context_->stats.num_strings -= 1;
+    pool_context_->stats.used_bytes -= s->size_;
+    pool_context_->stats.reclaimed_bytes -= s->size_;
+    pool_context_->set.erase(String((uint64_t)s));
+    pool_context_->large_chunks.erase(this);
+
+    // Release the own reference to destroy the chunk
+    decrement_refcount();
+    return;
+  }
 
-  mutex_.Unlock();
+  fragmented_size_.store(0, std::memory_order_release);
 }
 
-void Chunk::reallocate(InternalString* s) {
+void Chunk::reallocate(InternalString* s, char* data) {
   spdlog::trace("Reallocating the string {}", (void*)s);
-  const char* from = s->data_;
-  char* to = &data_[next_data_];
-  s->data_ = to;
+  char* to = &data[next_data_];
+  memcpy(to, s->data(), s->size_);
+  s->data_.store(to, std::memory_order_release);
   next_data_ += s->size_;
-  if (from != to) {
-    for (size_t i = s->size_; i; --i) {
-      *to++ = *from++;
-    }
-  }
 }
 
 
 bool make_small_string(const std::string& str, uint64_t& result) {
+  size_t size = str.size();
   result = 0;
-  if (str.size() <= 7) {
-    for (ssize_t i = str.size()-1; i >= 0; --i) {
+  if (size <= 7) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(&result, str.data(), size);
+    result <<= 8;
+#else
+    for (ssize_t i = size-1; i >= 0; --i) {
       result |= static_cast<uint8_t>(str[i]);
       result <<= 8;
     }
-    result |= (str.size()<<2) | 1;
+#endif
+    result |= (size<<2) | 1;
 
     return true;
-  } else if (str.size() <= 10) {
-    for (ssize_t i = str.size()-1; i >= 0; --i) {
-      result <<= 6;
-      char c = ASCII_CHAR_TO_CODED_VALUE[static_cast<uint8_t>(str[i])];
-      if (c == 127) return false;
-      result |= c;
+  } else if (size <= 10) {
+    // The invalid characters are coded as 127, so instead of check every
+    // character it's enough to check the seventh bit of all of them
+    const uint8_t* s = (const uint8_t*) str.data();
+    uint8_t invalid = 0;
+    for (size_t i = size; i > 0; --i) {
+      uint8_t c = ASCII_CHAR_TO_CODED_VALUE[s[i-1]];
+      invalid |= c;
+      result = (result << 6) | c;
     }
+    if (invalid & 64) return false;
+
     result <<= 4;
-    result |= ((str.size()-8)<<2) | 3;
+    result |= ((size-8)<<2) | 3;
 
     return true;
   }
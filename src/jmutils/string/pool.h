@@ -9,18 +9,31 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <charconv>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <variant>
 #include <vector>
 
 #include "absl/hash/hash.h"
+#include "jmutils/common.h"
+#include "jmutils/epoch.h"
+#include "jmutils/time.h"
 #include "spdlog/spdlog.h"
 
 #define CHUNK_DATA_SIZE (1<<16)
+#define CHUNK_FREE_SPACE_BINS 17
+#define CHUNK_WITHOUT_FREE_SPACE_BIN 0xff
+#define LARGE_STRING_MIN_SIZE (CHUNK_DATA_SIZE>>2)
+#define CHUNK_MIN_FRAGMENTED_SIZE_TO_COMPACT (CHUNK_DATA_SIZE>>3)
+#define POOL_NUM_SHARDS 8
 
 namespace jmutils
 {
@@ -28,13 +41,13 @@ namespace string
 {
 
   namespace {
-    const static char* CODED_VALUE_TO_ASCII_CHAR = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-";
     const static char ASCII_CHAR_TO_CODED_VALUE[] = {127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 63, 127, 127, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 127, 127, 127, 127, 127, 127, 127, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 127, 127, 127, 127, 62, 127, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127};
 
   }
 
   class Chunk;
   class String;
+  class PinnedString;
 
   class alignas(8) InternalString final
   {
@@ -51,28 +64,37 @@ namespace string
       return hash_;
     }
 
-    inline uint32_t size() const {
+    inline size_t size() const {
       return size_;
     }
 
     inline std::string str() const;
 
+    inline void copy(char* output) const;
+
   private:
     friend class Chunk;
     friend class String;
+    friend class PinnedString;
     friend String make_string(const std::string& str, InternalString* internal_string);
     friend bool operator==(const InternalString& lhs, const InternalString& rhs);
     friend bool operator==(const InternalString& lhs, const std::string& rhs);
 
     mutable std::atomic<int32_t> refcount_;
-    uint32_t size_;
+    size_t size_;
     size_t hash_;
-    const char* data_;
+    // The compaction could change it, so to read the characters of a
+    // string in a chunk it's necessary to hold a epoch guard
+    std::atomic<const char*> data_;
     Chunk* chunk_;
     InternalString* next_;
 
     void init(const std::string& str, const char* data, Chunk* chunk);
 
+    inline const char* data() const {
+      return data_.load(std::memory_order_acquire);
+    }
+
     inline void increment_refcount() {
       refcount_.fetch_add(1, std::memory_order_relaxed);
     }
@@ -116,12 +138,19 @@ namespace string
 
     std::string str() const;
 
+    // Copy the characters to the output, that must have at least size() bytes
+    void copy(char* output) const;
+
+    // Copy the characters to the range [first, last) like std::to_chars
+    std::to_chars_result to_chars(char* first, char* last) const;
+
     template <typename H>
     friend H AbslHashValue(H h, const String& s) {
       return H::combine(std::move(h), s.hash());
     }
 
   private:
+    friend class PinnedString;
     friend bool operator==(const String& lhs, const String& rhs);
     friend bool operator==(const String& lhs, const std::string& rhs);
 
@@ -162,6 +191,39 @@ namespace string
 
   static_assert(sizeof(String) == 8, "The size of the String must be 8 bytes");
 
+  // Expose the characters of a string without copy them, the small strings
+  // are decoded in a internal buffer and the compaction can't release the
+  // data of a chunk while the view is alive, so it should be short lived.
+  // The string must outlive the view.
+  class PinnedString final
+  {
+  public:
+    explicit PinnedString(const String& s);
+
+    PinnedString(const PinnedString& o) = delete;
+    PinnedString(PinnedString&& o) = delete;
+
+    PinnedString& operator=(const PinnedString& o) = delete;
+    PinnedString& operator=(PinnedString&& o) = delete;
+
+    inline std::string_view view() const {
+      return view_;
+    }
+
+    inline const char* data() const {
+      return view_.data();
+    }
+
+    inline size_t size() const {
+      return view_.size();
+    }
+
+  private:
+    std::optional<epoch::Guard> guard_;
+    std::string_view view_;
+    char buffer_[11];
+  };
+
 } /* string */
 } /* jmutils */
 
@@ -184,25 +246,44 @@ namespace string
 struct stats_t {
   uint32_t num_strings{0};
   uint32_t num_chunks{0};
-  uint32_t reclaimed_bytes{0};
-  uint32_t used_bytes{0};
+  uint64_t reclaimed_bytes{0};
+  uint64_t used_bytes{0};
 };
 
+struct stats_delta_t {
+  int64_t num_strings{0};
+  int64_t num_chunks{0};
+  int64_t reclaimed_bytes{0};
+  int64_t used_bytes{0};
+};
+
+// It receives the changes of the stats of a shard, so the observer must
+// accumulate them to obtain the stats of the pool
 class StatsObserver
 {
 public:
   virtual ~StatsObserver() {
   }
 
-  virtual void on_updated_stats(const stats_t& stats, bool force) {
+  virtual void on_updated_stats(const stats_delta_t& delta, bool force) {
   }
 };
 
+// A shard of the pool, the strings are distributed by hash between them
 struct pool_context_t {
   absl::flat_hash_set<String> set;
   absl::Mutex mutex;
   stats_t stats;
+  StatsObserver* stats_observer{nullptr};
   bool active{true};
+  std::vector<Chunk*> chunks;
+  // The large chunks aren't compacted, they are only tracked to release
+  // them when the pool is destroyed
+  absl::flat_hash_set<Chunk*> large_chunks;
+  // The chunk where the new strings are added and the rest of the chunks
+  // with some free space binned by the most significant bit of that space
+  Chunk* current_chunk{nullptr};
+  std::array<std::vector<Chunk*>, CHUNK_FREE_SPACE_BINS> chunks_by_free_space;
 };
 
 class Pool final
@@ -220,39 +301,80 @@ public:
   Pool& operator=(Pool&& o) = delete;
 
   String add(const std::string& str);
-  const stats_t& stats() const;
+
+  // Add a string of the given size whose characters are written by the
+  // function in a buffer reused by the thread, so it's rendered without
+  // allocations and only copied to a chunk if it isn't in the pool. The
+  // function can't add strings of this way
+  template <typename F>
+  String add(size_t size, F fill) {
+    thread_local std::string buffer;
+    buffer.resize(size);
+    fill(buffer.data());
+    return add(buffer);
+  }
+
+  // Add all the strings taking the lock of every shard at most twice,
+  // the result has the strings in the same order
+  void add(const std::vector<std::string>& strs, std::vector<String>& result);
+
+  stats_t stats() const;
   void compact();
 
+  // Compact the most fragmented chunks first, taking the lock only to compact
+  // a chunk and releasing the empty ones. It return true if all the
+  // fragmented chunks has been compacted before the deadline
+  bool compact(const MonotonicTimePoint& deadline);
+
 private:
   friend class Chunk;
 
   std::unique_ptr<StatsObserver> stats_observer_;
-  std::shared_ptr<pool_context_t> pool_context_;
-  std::vector<Chunk*> chunks_;
+  std::array<std::shared_ptr<pool_context_t>, POOL_NUM_SHARDS> shards_;
+  absl::Mutex compaction_mutex_;
+
+  const String store_string(
+    const std::shared_ptr<pool_context_t>& shard,
+    const std::string& str
+  );
 
-  const String store_string(const std::string& str);
+  Chunk* obtain_chunk(const std::shared_ptr<pool_context_t>& shard, size_t size);
+  Chunk* new_chunk(const std::shared_ptr<pool_context_t>& shard);
+  Chunk* new_large_chunk(const std::shared_ptr<pool_context_t>& shard, size_t size);
+  void release_chunk(const std::shared_ptr<pool_context_t>& shard, Chunk* chunk);
 
-  Chunk* new_chunk();
+  static void release_chunk_data(void* data);
 };
 
+// The modifications of the chunks are serialized by the pool mutex, while the
+// readers don't take any lock: the compaction copy the strings to a new buffer
+// and the old one is released once the readers that could use it finish.
+//
+// The large strings have a dedicated chunk with the size of the string, it's
+// never compacted and it's released with the string.
 class Chunk final
 {
 private:
   friend class InternalString;
   friend class Pool;
-  friend bool operator==(const InternalString& lhs, const InternalString& rhs);
-  friend bool operator==(const InternalString& lhs, const std::string& rhs);
 
   mutable std::atomic<uint32_t> refcount_;
-  std::atomic<int32_t> fragmented_size_;
-  absl::Mutex mutex_;
+  std::atomic<int64_t> fragmented_size_;
   std::shared_ptr<pool_context_t> pool_context_;
-  uint32_t next_data_;
+  size_t next_data_;
+  bool large_;
+  uint8_t free_space_bin_;
+  uint32_t free_space_idx_;
   InternalString* head_;
   InternalString* tail_;
-  char data_[CHUNK_DATA_SIZE];
+  char* data_;
 
-  explicit Chunk(std::shared_ptr<pool_context_t> pool_context);
+  explicit Chunk(
+    std::shared_ptr<pool_context_t> pool_context,
+    bool large = false,
+    size_t data_size = CHUNK_DATA_SIZE
+  );
+  ~Chunk();
 
   Chunk(const Chunk& o) = delete;
   Chunk(Chunk&& o) = delete;
@@ -268,43 +390,37 @@ private:
     }
   }
 
-  void released_string(uint32_t size);
+  inline uint32_t free_space() const {
+    return CHUNK_DATA_SIZE - next_data_;
+  }
+
+  void index_free_space();
+  void unindex_free_space();
+
+  void released_string(size_t size);
 
   String add(const std::string& str);
 
   void compact();
+  void compact_large();
 
-  void reallocate(InternalString* s);
+  void reallocate(InternalString* s, char* data);
 };
 
 
+bool make_small_string(const std::string& str, uint64_t& result);
+
 inline bool operator==(const InternalString& lhs, const InternalString& rhs) {
   if (&lhs == &rhs) return true;
   if ((lhs.hash_ != rhs.hash_) || (lhs.size_ != rhs.size_)) return false;
 
   if (lhs.chunk_ == rhs.chunk_) {
     if (lhs.chunk_ != nullptr) return false;
-    return memcmp(lhs.data_, rhs.data_, lhs.size_) == 0;
-  } else if (lhs.chunk_ != nullptr) {
-    bool result;
-    lhs.chunk_->mutex_.ReaderLock();
-    if (rhs.chunk_ != nullptr) {
-      rhs.chunk_->mutex_.ReaderLock();
-      result = memcmp(lhs.data_, rhs.data_, lhs.size_) == 0;
-      rhs.chunk_->mutex_.ReaderUnlock();
-    } else {
-      result = memcmp(lhs.data_, rhs.data_, lhs.size_) == 0;
-    }
-    lhs.chunk_->mutex_.ReaderUnlock();
-    return result;
-  } else if (rhs.chunk_ != nullptr) {
-    rhs.chunk_->mutex_.ReaderLock();
-    bool result = memcmp(lhs.data_, rhs.data_, lhs.size_) == 0;
-    rhs.chunk_->mutex_.ReaderUnlock();
-    return result;
+    return memcmp(lhs.data(), rhs.data(), lhs.size_) == 0;
   }
 
-  return memcmp(lhs.data_, rhs.data_, lhs.size_) == 0;
+  epoch::Guard guard;
+  return memcmp(lhs.data(), rhs.data(), lhs.size_) == 0;
 }
 
 inline bool operator!=(const InternalString& lhs, const InternalString& rhs) {
@@ -315,13 +431,11 @@ inline bool operator==(const InternalString& lhs, const std::string& rhs) {
   if (lhs.size_ != rhs.size()) return false;
 
   if (lhs.chunk_ != nullptr) {
-    lhs.chunk_->mutex_.ReaderLock();
-    bool result = memcmp(lhs.data_, rhs.c_str(), lhs.size_) == 0;
-    lhs.chunk_->mutex_.ReaderUnlock();
-    return result;
+    epoch::Guard guard;
+    return memcmp(lhs.data(), rhs.c_str(), lhs.size_) == 0;
   }
 
-  return memcmp(lhs.data_, rhs.c_str(), lhs.size_) == 0;
+  return memcmp(lhs.data(), rhs.c_str(), lhs.size_) == 0;
 }
 
 inline bool operator!=(const InternalString& lhs, const std::string& rhs) {
@@ -343,22 +457,10 @@ inline bool operator!=(const String& lhs, const String& rhs) {
 inline bool operator==(const String& lhs, const std::string& rhs) {
   if (lhs.data_ == 0) return false;
   if (lhs.is_small()) {
-    uint64_t data = lhs.data_;
-    if (data & 2) {
-      if ((((data>>2) & 3) + 8) != rhs.size()) return false;
-      data >>= 4;
-      for (size_t i = 0, end = rhs.size(); i < end; ++i) {
-        if (CODED_VALUE_TO_ASCII_CHAR[data & 63] != rhs[i]) return false;
-        data >>= 6;
-      }
-    } else {
-      if (((data>>2) & 7) != rhs.size()) return false;
-      for (size_t i = 0, end = rhs.size(); i < end; ++i) {
-        data >>= 8;
-        if (static_cast<char>(data & 255) != rhs[i]) return false;
-      }
-    }
-    return true;
+    // The small representation of a string is unique, so it's cheaper
+    // to encode the other string and compare the words
+    uint64_t data;
+    return make_small_string(rhs, data) && (data == lhs.data_);
   }
 
   return *((InternalString*) lhs.data_) == rhs;
@@ -370,7 +472,7 @@ inline bool operator!=(const String& lhs, const std::string& rhs) {
 
 
 inline bool operator==(const std::string& lhs, const String& rhs) {
-  return !(rhs == lhs);
+  return rhs == lhs;
 }
 
 inline bool operator!=(const std::string& lhs, const String& rhs) {
@@ -378,8 +480,6 @@ inline bool operator!=(const std::string& lhs, const String& rhs) {
 }
 
 
-bool make_small_string(const std::string& str, uint64_t& result);
-
 String make_small_string(const std::string& str);
 String make_string(const std::string& str, InternalString* internal_string);
 
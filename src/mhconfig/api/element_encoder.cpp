@@ -0,0 +1,197 @@
+#include "mhconfig/api/element_encoder.h"
+
+namespace mhconfig
+{
+namespace api
+{
+
+ElementEncoder::ElementEncoder(
+  uint32_t field_number,
+  bool with_position,
+  SourceIds& source_ids
+) : field_tag_((field_number << 3) | 2),
+  with_position_(with_position),
+  source_ids_(source_ids)
+{
+}
+
+ElementEncoder::~ElementEncoder() {
+  delete[] data_;
+}
+
+void ElementEncoder::encode(const Element& root, std::string& output) {
+  size_ = 0;
+  encode_rec(root, nullptr, true);
+  output.append(data_ + (capacity_ - size_), size_);
+}
+
+uint32_t ElementEncoder::encode_rec(
+  const Element& element,
+  const Literal* key,
+  bool is_last
+) {
+  uint32_t num_elements = 1;
+  uint32_t container_size = 0;
+
+  switch (element.type()) {
+    case Element::Type::MAP: {
+      auto map = element.as_map();
+      container_size = map->size();
+
+      // The map iterators can't go backward
+      size_t first_idx = map_values_.size();
+      for (const auto& it : *map) {
+        map_values_.push_back(&it);
+      }
+      for (size_t i = map_values_.size(); i > first_idx; --i) {
+        const auto* value = map_values_[i-1];
+        num_elements += encode_rec(
+          value->second,
+          &value->first,
+          i == map_values_.size()
+        );
+      }
+      map_values_.resize(first_idx);
+      break;
+    }
+
+    case Element::Type::SEQUENCE: {
+      auto seq = element.as_seq();
+      container_size = seq->size();
+
+      for (size_t i = seq->size(); i > 0; --i) {
+        num_elements += encode_rec((*seq)[i-1], nullptr, i == seq->size());
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+
+  size_t end = size_;
+
+  if (with_position_ && (element.document_id() != 0xffff) && (element.raw_config_id() != 0xffff)) {
+    source_ids_.emplace(element.document_id(), element.raw_config_id());
+    encode_position(element);
+  }
+
+  if (key != nullptr) {
+    push_literal(10, *key);
+  }
+
+  proto::Element::ValueType value_type = proto::Element_ValueType_UNDEFINED;
+  switch (element.type()) {
+    case Element::Type::UNDEFINED:
+      break;
+
+    case Element::Type::NONE:
+      value_type = proto::Element_ValueType_NONE;
+      break;
+
+    case Element::Type::STR:
+      value_type = proto::Element_ValueType_STR;
+      push_literal(5, element.as<Literal>());
+      break;
+
+    case Element::Type::BIN:
+      value_type = proto::Element_ValueType_BIN;
+      push_literal(6, element.as<Literal>());
+      break;
+
+    case Element::Type::INT64: {
+      value_type = proto::Element_ValueType_INT64;
+      int64_t v = element.as<int64_t>();
+      push_varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+      push_varint(7 << 3);
+      break;
+    }
+
+    case Element::Type::DOUBLE:
+      value_type = proto::Element_ValueType_DOUBLE;
+      push_double(element.as<double>());
+      push_varint((9 << 3) | 1);
+      break;
+
+    case Element::Type::BOOL:
+      value_type = proto::Element_ValueType_BOOL;
+      push_varint(element.as<bool>() ? 1 : 0);
+      push_varint(8 << 3);
+      break;
+
+    case Element::Type::MAP: // Fallback
+    case Element::Type::SEQUENCE:
+      value_type = element.type() == Element::Type::MAP
+        ? proto::Element_ValueType_MAP
+        : proto::Element_ValueType_SEQUENCE;
+      if (container_size != 0) {
+        push_varint(container_size);
+        push_varint(4 << 3);
+      }
+      break;
+  }
+
+  if (!is_last && (num_elements > 1)) {
+    push_varint(num_elements-1);
+    push_varint(3 << 3);
+  }
+
+  if (value_type != proto::Element_ValueType_STR) {
+    push_varint(value_type);
+    push_varint(2 << 3);
+  }
+
+  push_varint(size_ - end);
+  push_varint(field_tag_);
+
+  return num_elements;
+}
+
+void ElementEncoder::encode_position(const Element& element) {
+  size_t end = size_;
+
+  if (element.col() != 0) {
+    push_varint(element.col());
+    push_varint(4 << 3);
+  }
+
+  if (element.line() != 0) {
+    push_varint(element.line());
+    push_varint(3 << 3);
+  }
+
+  auto id = make_source_id(element.document_id(), element.raw_config_id());
+  if (id != 0) {
+    push_fixed32(id);
+    push_varint((2 << 3) | 5);
+  }
+
+  push_varint(1);
+  push_varint(1 << 3);
+
+  push_varint(size_ - end);
+  push_varint((11 << 3) | 2);
+}
+
+void ElementEncoder::grow(size_t n) {
+  size_t capacity = std::max(std::max(capacity_*2, size_+n), (size_t) 256);
+  char* data = new char[capacity];
+  memcpy(data + (capacity - size_), data_ + (capacity_ - size_), size_);
+  delete[] data_;
+  data_ = data;
+  capacity_ = capacity;
+}
+
+std::shared_ptr<const encoded_elements_t> encode_elements(
+  const Element& root,
+  uint32_t field_number,
+  bool with_position
+) {
+  auto encoded = std::make_shared<encoded_elements_t>();
+  ElementEncoder encoder(field_number, with_position, encoded->source_ids);
+  encoder.encode(root, encoded->data);
+  return encoded;
+}
+
+} /* api */
+} /* mhconfig */
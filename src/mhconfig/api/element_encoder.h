@@ -0,0 +1,126 @@
+#ifndef MHCONFIG__API__ELEMENT_ENCODER_H
+#define MHCONFIG__API__ELEMENT_ENCODER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mhconfig/api/common.h"
+#include "mhconfig/element.h"
+
+namespace mhconfig
+{
+namespace api
+{
+
+// The elements of a config encoded as the repeated field of a response,
+// with the sources referenced by their positions
+struct encoded_elements_t {
+  std::string data;
+  SourceIds source_ids;
+};
+
+// Encode the elements of a tree directly in the protobuf wire format as the
+// repeated field `field_number` of a message, producing the same bytes that
+// the serialization of the same elements filled with the protobuf API.
+//
+// The buffer is written from the end to the beginning, in that way when the
+// header of a map or a sequence is written the number of elements of all
+// his children is already known and it's possible to do it in one pass.
+class ElementEncoder final
+{
+public:
+  ElementEncoder(
+    uint32_t field_number,
+    bool with_position,
+    SourceIds& source_ids
+  );
+  ~ElementEncoder();
+
+  ElementEncoder(const ElementEncoder& o) = delete;
+  ElementEncoder(ElementEncoder&& o) = delete;
+
+  ElementEncoder& operator=(const ElementEncoder& o) = delete;
+  ElementEncoder& operator=(ElementEncoder&& o) = delete;
+
+  void encode(const Element& root, std::string& output);
+
+private:
+  uint32_t field_tag_;
+  bool with_position_;
+  SourceIds& source_ids_;
+
+  char* data_{nullptr};
+  size_t capacity_{0};
+  size_t size_{0};
+
+  std::vector<const Map::value_type*> map_values_;
+
+  uint32_t encode_rec(
+    const Element& element,
+    const Literal* key,
+    bool is_last
+  );
+
+  void encode_position(const Element& element);
+
+  inline char* push_front(size_t n) {
+    if (size_ + n > capacity_) {
+      grow(n);
+    }
+    size_ += n;
+    return data_ + (capacity_ - size_);
+  }
+
+  void grow(size_t n);
+
+  inline void push_varint(uint64_t n) {
+    char buffer[10];
+    size_t l = 0;
+    while (n >= 0x80) {
+      buffer[l++] = static_cast<char>(n | 0x80);
+      n >>= 7;
+    }
+    buffer[l++] = static_cast<char>(n);
+    memcpy(push_front(l), buffer, l);
+  }
+
+  inline void push_fixed32(uint32_t n) {
+    char* output = push_front(4);
+    output[0] = n & 0xff;
+    output[1] = (n >> 8) & 0xff;
+    output[2] = (n >> 16) & 0xff;
+    output[3] = (n >> 24) & 0xff;
+  }
+
+  inline void push_double(double n) {
+    uint64_t v;
+    memcpy(&v, &n, sizeof(v));
+    char* output = push_front(8);
+    for (size_t i = 0; i < 8; ++i) {
+      output[i] = (v >> (i*8)) & 0xff;
+    }
+  }
+
+  inline void push_literal(uint32_t field_number, const Literal& literal) {
+    size_t size = literal.size();
+    literal.copy(push_front(size));
+    push_varint(size);
+    push_varint((field_number << 3) | 2);
+  }
+};
+
+std::shared_ptr<const encoded_elements_t> encode_elements(
+  const Element& root,
+  uint32_t field_number,
+  bool with_position
+);
+
+} /* api */
+} /* mhconfig */
+
+#endif
@@ -1,12 +1,14 @@
 #ifndef MHCONFIG__API__REQUEST__GET_REQUEST_H
 #define MHCONFIG__API__REQUEST__GET_REQUEST_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "jmutils/container/label_set.h"
 #include "mhconfig/api/commitable.h"
 #include "mhconfig/api/common.h"
+#include "mhconfig/api/response_encoder.h"
 
 namespace mhconfig
 {
@@ -29,6 +31,7 @@ public:
   virtual const std::string& document() const = 0;
   virtual LogLevel log_level() const = 0;
   virtual bool with_position() const = 0;
+  virtual ResponseType response_type() const = 0;
 
   virtual void set_namespace_id(uint64_t namespace_id) = 0;
   virtual void set_version(uint32_t version) = 0;
@@ -57,6 +60,16 @@ public:
   virtual void set_sources(const std::vector<source_t>& sources) = 0;
 
   virtual void set_checksum(const uint8_t* data, size_t len) = 0;
+
+  // Set the elements already encoded in the field of the response type
+  virtual void set_encoded_elements(
+    std::shared_ptr<const encoded_elements_t> elements
+  ) = 0;
+
+  // Set the logs & sources already encoded in the fields of the response type
+  virtual void set_encoded_logs(
+    std::shared_ptr<const encoded_logs_t> logs
+  ) = 0;
 };
 
 } /* request */
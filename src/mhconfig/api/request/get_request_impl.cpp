@@ -45,6 +45,10 @@ bool GetRequestImpl::with_position() const {
     return request_->with_position();
 }
 
+ResponseType GetRequestImpl::response_type() const {
+  return ResponseType::GET;
+}
+
 void GetRequestImpl::set_namespace_id(uint64_t namespace_id) {
   response_->set_namespace_id(namespace_id);
 }
@@ -54,30 +58,22 @@ void GetRequestImpl::set_version(uint32_t version) {
 }
 
 void GetRequestImpl::set_element(const mhconfig::Element& element) {
-  response_->clear_elements();
-  SourceIds source_ids;
-  fill_elements(
+  elements_ = encode_elements(
     element,
-    response_,
-    response_->add_elements(),
-    false,
-    source_ids
+    mhconfig::proto::GetResponse::kElementsFieldNumber,
+    false
   );
 }
 
 SourceIds GetRequestImpl::set_element_with_position(
   const mhconfig::Element& element
 ) {
-  response_->clear_elements();
-  SourceIds source_ids;
-  fill_elements(
+  elements_ = encode_elements(
     element,
-    response_,
-    response_->add_elements(),
-    true,
-    source_ids
+    mhconfig::proto::GetResponse::kElementsFieldNumber,
+    true
   );
-  return source_ids;
+  return elements_->source_ids;
 }
 
 void GetRequestImpl::add_log(
@@ -124,6 +120,17 @@ void GetRequestImpl::set_checksum(const uint8_t* data, size_t len) {
   response_->set_checksum(data, len);
 }
 
+void GetRequestImpl::set_encoded_elements(
+  std::shared_ptr<const encoded_elements_t> elements
+) {
+  elements_ = std::move(elements);
+}
+
+void GetRequestImpl::set_encoded_logs(
+  std::shared_ptr<const encoded_logs_t> logs
+) {
+  logs_ = std::move(logs);
+}
 
 bool GetRequestImpl::commit() {
   return finish();
@@ -134,7 +141,7 @@ void GetRequestImpl::subscribe(
   grpc::ServerCompletionQueue* cq
 ) {
   if (auto t = make_tag(GrpcStatus::CREATE)) {
-    service->RequestGet(&server_ctx_, request_, &responder_, cq, cq, t);
+    service->RequestEncodedGet(&server_ctx_, request_, &responder_, cq, cq, t);
   }
 }
 
@@ -188,7 +195,11 @@ void GetRequestImpl::on_check_policy_error() {
 bool GetRequestImpl::finish(const grpc::Status& status) {
   if (auto t = make_tag(GrpcStatus::WRITE)) {
     if (status.ok()) {
-      responder_.Finish(*response_, status, t);
+      responder_.Finish(
+        make_response_buffer(*response_, elements_, logs_),
+        status,
+        t
+      );
     } else {
       responder_.FinishWithError(status, t);
     }
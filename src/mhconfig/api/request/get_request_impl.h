@@ -18,6 +18,7 @@
 #include "mhconfig/api/common.h"
 #include "mhconfig/api/request/get_request.h"
 #include "mhconfig/api/request/request.h"
+#include "mhconfig/api/response_encoder.h"
 #include "mhconfig/api/session.h"
 #include "mhconfig/config_namespace.h"
 #include "mhconfig/context.h"
@@ -59,6 +60,7 @@ public:
   const std::string& document() const override;
   LogLevel log_level() const override;
   bool with_position() const override;
+  ResponseType response_type() const override;
 
   void set_namespace_id(uint64_t namespace_id) override;
   void set_version(uint32_t version) override;
@@ -87,6 +89,14 @@ public:
   void set_sources(const std::vector<source_t>& sources) override;
   void set_checksum(const uint8_t* data, size_t len) override;
 
+  void set_encoded_elements(
+    std::shared_ptr<const encoded_elements_t> elements
+  ) override;
+
+  void set_encoded_logs(
+    std::shared_ptr<const encoded_logs_t> logs
+  ) override;
+
   bool commit() override;
   bool finish(const grpc::Status& status = grpc::Status::OK) override;
 
@@ -104,10 +114,12 @@ public:
 
 protected:
   google::protobuf::Arena arena_;
-  grpc::ServerAsyncResponseWriter<mhconfig::proto::GetResponse> responder_;
+  grpc::ServerAsyncResponseWriter<grpc::ByteBuffer> responder_;
 
   mhconfig::proto::GetRequest* request_;
   mhconfig::proto::GetResponse* response_;
+  std::shared_ptr<const encoded_elements_t> elements_;
+  std::shared_ptr<const encoded_logs_t> logs_;
 
   Labels labels_;
   Element element_;
@@ -0,0 +1,124 @@
+#include "mhconfig/api/response_encoder.h"
+
+namespace mhconfig
+{
+namespace api
+{
+
+LogsEncoder::LogsEncoder(ResponseType response_type) {
+  switch (response_type) {
+    case ResponseType::GET:
+      get_response_ = google::protobuf::Arena::CreateMessage<mhconfig::proto::GetResponse>(&arena_);
+      break;
+    case ResponseType::WATCH:
+      watch_response_ = google::protobuf::Arena::CreateMessage<mhconfig::proto::WatchResponse>(&arena_);
+      break;
+  }
+}
+
+LogsEncoder::~LogsEncoder() {
+}
+
+void LogsEncoder::add_log(
+  LogLevel level,
+  const std::string_view& message
+) {
+  auto log = make_log();
+  log->set_level(level_to_proto(level));
+  log->set_message(message.data(), message.size());
+}
+
+void LogsEncoder::add_log(
+  LogLevel level,
+  const std::string_view& message,
+  const position_t& position
+) {
+  auto log = make_log();
+  log->set_level(level_to_proto(level));
+  log->set_message(message.data(), message.size());
+  fill_position(position, log->mutable_position());
+}
+
+void LogsEncoder::add_log(
+  LogLevel level,
+  const std::string_view& message,
+  const position_t& position,
+  const position_t& source
+) {
+  auto log = make_log();
+  log->set_level(level_to_proto(level));
+  log->set_message(message.data(), message.size());
+  fill_position(position, log->mutable_position());
+  fill_position(source, log->mutable_origin());
+}
+
+void LogsEncoder::set_sources(const std::vector<source_t>& sources) {
+  if (get_response_ != nullptr) {
+    get_response_->clear_sources();
+    fill_sources(sources, get_response_);
+  } else {
+    watch_response_->clear_sources();
+    fill_sources(sources, watch_response_);
+  }
+}
+
+std::string LogsEncoder::encode() const {
+  // Only the logs & sources are set, so the serialization is the
+  // encoding of that fields
+  if (get_response_ != nullptr) {
+    return get_response_->SerializeAsString();
+  }
+  return watch_response_->SerializeAsString();
+}
+
+mhconfig::proto::Log* LogsEncoder::make_log() {
+  if (get_response_ != nullptr) {
+    return get_response_->add_logs();
+  }
+  return watch_response_->add_logs();
+}
+
+template <typename T>
+static void release_encoded(void* user_data) {
+  delete static_cast<std::shared_ptr<const T>*>(user_data);
+}
+
+template <typename T>
+static void append_encoded(
+  const std::shared_ptr<const T>& encoded,
+  grpc::Slice* slices,
+  size_t& num_slices
+) {
+  if ((encoded != nullptr) && !encoded->data.empty()) {
+    slices[num_slices++] = grpc::Slice(
+      const_cast<char*>(encoded->data.data()),
+      encoded->data.size(),
+      release_encoded<T>,
+      new std::shared_ptr<const T>(encoded)
+    );
+  }
+}
+
+grpc::ByteBuffer make_response_buffer(
+  const google::protobuf::MessageLite& message,
+  const std::shared_ptr<const encoded_elements_t>& elements,
+  const std::shared_ptr<const encoded_logs_t>& logs
+) {
+  grpc::Slice slices[3];
+  size_t num_slices = 0;
+
+  size_t size = message.ByteSizeLong();
+  if (size != 0) {
+    grpc::Slice slice(size);
+    message.SerializeWithCachedSizesToArray(const_cast<uint8_t*>(slice.begin()));
+    slices[num_slices++] = std::move(slice);
+  }
+
+  append_encoded(elements, slices, num_slices);
+  append_encoded(logs, slices, num_slices);
+
+  return grpc::ByteBuffer(slices, num_slices);
+}
+
+} /* api */
+} /* mhconfig */
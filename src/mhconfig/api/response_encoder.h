@@ -0,0 +1,86 @@
+#ifndef MHCONFIG__API__RESPONSE_ENCODER_H
+#define MHCONFIG__API__RESPONSE_ENCODER_H
+
+#include <google/protobuf/arena.h>
+#include <google/protobuf/message_lite.h>
+#include <grpcpp/impl/codegen/byte_buffer.h>
+#include <grpcpp/impl/codegen/slice.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mhconfig/api/common.h"
+#include "mhconfig/api/element_encoder.h"
+#include "mhconfig/proto/mhconfig.pb.h"
+
+namespace mhconfig
+{
+namespace api
+{
+
+// The logs & sources of a response encoded in the fields of its type,
+// the source ids are the ones that are present in the sources
+struct encoded_logs_t {
+  std::string data;
+  SourceIds source_ids;
+};
+
+// Collect the logs & sources of a response to encode them once, it could
+// be used as the message of a ApiLogger
+class LogsEncoder final
+{
+public:
+  explicit LogsEncoder(ResponseType response_type);
+  ~LogsEncoder();
+
+  LogsEncoder(const LogsEncoder& o) = delete;
+  LogsEncoder(LogsEncoder&& o) = delete;
+
+  LogsEncoder& operator=(const LogsEncoder& o) = delete;
+  LogsEncoder& operator=(LogsEncoder&& o) = delete;
+
+  void add_log(
+    LogLevel level,
+    const std::string_view& message
+  );
+  void add_log(
+    LogLevel level,
+    const std::string_view& message,
+    const position_t& position
+  );
+  void add_log(
+    LogLevel level,
+    const std::string_view& message,
+    const position_t& position,
+    const position_t& source
+  );
+
+  void set_sources(const std::vector<source_t>& sources);
+
+  std::string encode() const;
+
+private:
+  google::protobuf::Arena arena_;
+  mhconfig::proto::GetResponse* get_response_{nullptr};
+  mhconfig::proto::WatchResponse* watch_response_{nullptr};
+
+  mhconfig::proto::Log* make_log();
+};
+
+// Make the buffer to write a response, it's the serialization of the message
+// followed by the already encoded elements & logs, that are appended without
+// copy them keeping a reference while gRPC use the buffer.
+//
+// The protobuf parsers accept the fields in any order, so the elements
+// could be encoded out of the message
+grpc::ByteBuffer make_response_buffer(
+  const google::protobuf::MessageLite& message,
+  const std::shared_ptr<const encoded_elements_t>& elements,
+  const std::shared_ptr<const encoded_logs_t>& logs
+);
+
+} /* api */
+} /* mhconfig */
+
+#endif
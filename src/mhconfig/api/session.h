@@ -4,6 +4,9 @@
 #include <assert.h>
 #include <bits/stdint-uintn.h>
 #include <google/protobuf/repeated_field.h>
+#include <grpcpp/impl/codegen/async_stream.h>
+#include <grpcpp/impl/codegen/async_unary_call.h>
+#include <grpcpp/impl/codegen/byte_buffer.h>
 #include <grpcpp/impl/codegen/completion_queue.h>
 #include <grpcpp/impl/codegen/server_context.h>
 #include <grpcpp/impl/codegen/status.h>
@@ -37,7 +40,52 @@ namespace api
 
 using google::protobuf::Arena;
 
-using CustomService = mhconfig::proto::MHConfig::AsyncService;
+// The get & watch responses are written as byte buffers to append the
+// encoded elements of the configs without parse them in a message
+class CustomService final : public mhconfig::proto::MHConfig::AsyncService
+{
+public:
+  void RequestEncodedGet(
+    grpc::ServerContext* context,
+    mhconfig::proto::GetRequest* request,
+    grpc::ServerAsyncResponseWriter<grpc::ByteBuffer>* response,
+    grpc::CompletionQueue* new_call_cq,
+    grpc::ServerCompletionQueue* notification_cq,
+    void* tag
+  ) {
+    RequestAsyncUnary(
+      GET_METHOD_IDX,
+      context,
+      request,
+      response,
+      new_call_cq,
+      notification_cq,
+      tag
+    );
+  }
+
+  void RequestEncodedWatch(
+    grpc::ServerContext* context,
+    grpc::ServerAsyncReaderWriter<grpc::ByteBuffer, mhconfig::proto::WatchRequest>* stream,
+    grpc::CompletionQueue* new_call_cq,
+    grpc::ServerCompletionQueue* notification_cq,
+    void* tag
+  ) {
+    RequestAsyncBidiStreaming(
+      WATCH_METHOD_IDX,
+      context,
+      stream,
+      new_call_cq,
+      notification_cq,
+      tag
+    );
+  }
+
+private:
+  // The position of the methods in the service definition
+  static constexpr int GET_METHOD_IDX = 0;
+  static constexpr int WATCH_METHOD_IDX = 1;
+};
 
 template <typename T>
 std::vector<T> to_vector(const ::google::protobuf::RepeatedPtrField<T>& proto_repeated) {
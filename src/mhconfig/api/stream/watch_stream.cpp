@@ -44,6 +44,10 @@ bool WatchGetRequest::with_position() const {
     return input_message_->with_position();
 }
 
+ResponseType WatchGetRequest::response_type() const {
+  return ResponseType::WATCH;
+}
+
 void WatchGetRequest::set_namespace_id(uint64_t namespace_id) {
   output_message_->set_namespace_id(namespace_id);
 }
@@ -96,6 +100,18 @@ void WatchGetRequest::set_checksum(const uint8_t* data, size_t len) {
   output_message_->set_checksum(data, len);
 }
 
+void WatchGetRequest::set_encoded_elements(
+  std::shared_ptr<const encoded_elements_t> elements
+) {
+  output_message_->set_encoded_elements(std::move(elements));
+}
+
+void WatchGetRequest::set_encoded_logs(
+  std::shared_ptr<const encoded_logs_t> logs
+) {
+  output_message_->set_encoded_logs(std::move(logs));
+}
+
 bool WatchGetRequest::commit() {
   return output_message_->commit();
 }
@@ -73,6 +73,14 @@ public:
   virtual void set_sources(const std::vector<source_t>& sources) = 0;
 
   virtual void set_checksum(const uint8_t* data, size_t len) = 0;
+
+  virtual void set_encoded_elements(
+    std::shared_ptr<const encoded_elements_t> elements
+  ) = 0;
+
+  virtual void set_encoded_logs(
+    std::shared_ptr<const encoded_logs_t> logs
+  ) = 0;
 };
 
 class WatchInputMessage
@@ -113,6 +121,7 @@ public:
   const std::string& document() const override;
   LogLevel log_level() const override;
   bool with_position() const override;
+  ResponseType response_type() const override;
 
   void set_namespace_id(uint64_t namespace_id) override;
   void set_version(uint32_t version) override;
@@ -141,6 +150,14 @@ public:
   void set_sources(const std::vector<source_t>& sources) override;
   void set_checksum(const uint8_t* data, size_t len) override;
 
+  void set_encoded_elements(
+    std::shared_ptr<const encoded_elements_t> elements
+  ) override;
+
+  void set_encoded_logs(
+    std::shared_ptr<const encoded_logs_t> logs
+  ) override;
+
   bool commit() override;
 
 private:
@@ -37,30 +37,22 @@ void WatchOutputMessageImpl::set_version(uint32_t version) {
 }
 
 void WatchOutputMessageImpl::set_element(const mhconfig::Element& element) {
-  response_->clear_elements();
-  SourceIds source_ids;
-  fill_elements(
+  elements_ = encode_elements(
     element,
-    response_,
-    response_->add_elements(),
-    false,
-    source_ids
+    mhconfig::proto::WatchResponse::kElementsFieldNumber,
+    false
   );
 }
 
 SourceIds WatchOutputMessageImpl::set_element_with_position(
   const mhconfig::Element& element
 ) {
-  response_->clear_elements();
-  SourceIds source_ids;
-  fill_elements(
+  elements_ = encode_elements(
     element,
-    response_,
-    response_->add_elements(),
-    true,
-    source_ids
+    mhconfig::proto::WatchResponse::kElementsFieldNumber,
+    true
   );
-  return source_ids;
+  return elements_->source_ids;
 }
 
 void WatchOutputMessageImpl::add_log(
@@ -107,8 +99,21 @@ void WatchOutputMessageImpl::set_checksum(const uint8_t* data, size_t len) {
   response_->set_checksum(data, len);
 }
 
+void WatchOutputMessageImpl::set_encoded_elements(
+  std::shared_ptr<const encoded_elements_t> elements
+) {
+  elements_ = std::move(elements);
+}
+
+void WatchOutputMessageImpl::set_encoded_logs(
+  std::shared_ptr<const encoded_logs_t> logs
+) {
+  logs_ = std::move(logs);
+}
+
 bool WatchOutputMessageImpl::send(bool finish) {
   if (auto stream = stream_.lock()) {
+    buffer_ = make_response_buffer(*response_, elements_, logs_);
     return stream->send(shared_from_this(), finish);
   }
   return false;
@@ -302,7 +307,7 @@ void WatchStreamImpl::subscribe(
   grpc::ServerCompletionQueue* cq
 ) {
   if (auto t = make_tag(GrpcStatus::CREATE)) {
-    service->RequestWatch(&server_ctx_, &stream_, cq, cq, t);
+    service->RequestEncodedWatch(&server_ctx_, &stream_, cq, cq, t);
   }
 }
 
@@ -22,6 +22,7 @@
 #include "jmutils/container/label_set.h"
 #include "mhconfig/api/common.h"
 #include "mhconfig/api/request/get_request.h"
+#include "mhconfig/api/response_encoder.h"
 #include "mhconfig/api/session.h"
 #include "mhconfig/api/stream/stream.h"
 #include "mhconfig/api/stream/trace_stream.h"
@@ -87,21 +88,31 @@ public:
   void set_sources(const std::vector<source_t>& sources) override;
   void set_checksum(const uint8_t* data, size_t len) override;
 
+  void set_encoded_elements(
+    std::shared_ptr<const encoded_elements_t> elements
+  ) override;
+
+  void set_encoded_logs(
+    std::shared_ptr<const encoded_logs_t> logs
+  ) override;
+
   bool send(bool finish = false) override;
 
 protected:
-  friend class Stream<grpc::ServerAsyncReaderWriter<mhconfig::proto::WatchResponse, mhconfig::proto::WatchRequest>, WatchOutputMessageImpl>;
+  friend class Stream<grpc::ServerAsyncReaderWriter<grpc::ByteBuffer, mhconfig::proto::WatchRequest>, WatchOutputMessageImpl>;
 
-  inline const mhconfig::proto::WatchResponse& response() {
-    return *response_;
+  inline const grpc::ByteBuffer& response() {
+    return buffer_;
   }
 
 private:
   google::protobuf::Arena arena_;
   mhconfig::proto::WatchResponse* response_;
+  std::shared_ptr<const encoded_elements_t> elements_;
+  std::shared_ptr<const encoded_logs_t> logs_;
   std::weak_ptr<WatchStreamImpl> stream_;
 
-  grpc::Slice slice_;
+  grpc::ByteBuffer buffer_;
 
   inline WatchResponse_Status to_proto(WatchStatus status);
 };
@@ -147,7 +158,7 @@ private:
 };
 
 class WatchStreamImpl final
-  : public Stream<grpc::ServerAsyncReaderWriter<mhconfig::proto::WatchResponse, mhconfig::proto::WatchRequest>, WatchOutputMessageImpl>,
+  : public Stream<grpc::ServerAsyncReaderWriter<grpc::ByteBuffer, mhconfig::proto::WatchRequest>, WatchOutputMessageImpl>,
   public PolicyCheck,
   public std::enable_shared_from_this<WatchStreamImpl>
 {
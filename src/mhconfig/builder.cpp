@@ -6,6 +6,7 @@ namespace mhconfig
 // Setup logic
 
 bool init_config_namespace(
+    context_t* ctx,
     config_namespace_t* cn
 ) {
     cn->id = std::uniform_int_distribution<uint64_t>{0, 0xffffffffffffffff}(jmutils::prng_engine());
@@ -17,6 +18,7 @@ bool init_config_namespace(
     > updated_documents_by_labels;
 
     bool ok = index_files(
+        ctx,
         cn->pool.get(),
         cn->root_path,
         [cn, &updated_documents_by_labels](auto&& labels, auto&& result) {
@@ -55,6 +57,7 @@ bool init_config_namespace(
             document->raw_config_by_id[result.raw_config->id] = result.raw_config;
             auto override_ = document->lbl_set.get_or_build(labels);
             override_->raw_config_by_version[1] = std::move(result.raw_config);
+            document->overrides_versions.insert(1);
             document->mutex.Unlock();
 
             updated_documents_by_labels[labels][result.document] = AffectedDocumentStatus::TO_ADD;
@@ -192,7 +195,7 @@ load_raw_config_result_t index_file(
                     reference_to
                 );
 
-                result.raw_config->value = element_builder.make_and_check(node);
+                result.raw_config->value = element_builder.build(node);
             },
             result
         );
@@ -216,6 +219,34 @@ load_raw_config_result_t index_file(
     return result;
 }
 
+bool index_files_in_parallel(
+    context_t* ctx,
+    jmutils::string::Pool* pool,
+    const std::filesystem::path& root_path,
+    const std::vector<std::filesystem::path>& paths,
+    std::vector<load_raw_config_result_t>& results
+) {
+    results.clear();
+    results.resize(paths.size());
+
+    size_t max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    spdlog::debug(
+        "Indexing {} files with up to {} threads",
+        paths.size(),
+        max_threads
+    );
+
+    return worker::parallel_for(
+        ctx,
+        paths.size(),
+        max_threads,
+        [pool, &root_path, &paths, &results](size_t i) {
+            results[i] = index_file(pool, root_path, paths[i]);
+            return true;
+        }
+    );
+}
+
 std::optional<Labels> get_path_labels(
     const std::filesystem::path& path
 ) {
@@ -334,6 +365,7 @@ bool touch_affected_documents(
 
                     document->raw_config_by_id[new_raw_config->id] = new_raw_config;
                     override_->raw_config_by_version[version] = std::move(new_raw_config);
+                    document->overrides_versions.insert(version);
                 }
             }
         }
@@ -571,8 +603,10 @@ std::shared_ptr<document_t> try_migrate_document_locked(
                 auto new_raw_config = last_version->clone();
                 new_raw_config->id = new_document->next_raw_config_id++;
                 new_document->raw_config_by_id[new_raw_config->id] = new_raw_config;
+                new_document->migrated_raw_config_ids[new_raw_config->id] = last_version->id;
                 auto new_override = new_document->lbl_set.get_or_build(labels);
                 new_override->raw_config_by_version[version] = std::move(new_raw_config);
+                new_document->overrides_versions.insert(version);
             }
             return true;
         }
@@ -636,6 +670,7 @@ std::shared_ptr<document_t> try_obtain_non_full_document(
     if (required_size + document->next_raw_config_id >= 0xffff) {
         auto new_document = try_migrate_document_locked(cn, document.get(), version);
         if (new_document == nullptr) return nullptr;
+        new_document->migrated_from = document;
         std::swap(document, new_document);
         if (required_size + document->next_raw_config_id >= 0xffff) {
             document->mutex.Unlock();
@@ -646,6 +681,88 @@ std::shared_ptr<document_t> try_obtain_non_full_document(
     return document;
 }
 
+VersionId get_overrides_version_locked(
+    document_t* document,
+    VersionId version
+) {
+    auto it = document->overrides_versions.upper_bound(version);
+    if (it == document->overrides_versions.begin()) {
+        return 0;
+    }
+    return *std::prev(it);
+}
+
+bool get_overrides_key(
+    const Element& config,
+    document_t* cfg_document,
+    document_t* document,
+    const Labels& labels,
+    VersionId version,
+    std::string& overrides_key
+) {
+    // The weights of the labels are obtained from the config document,
+    // so the overrides also change with it
+    VersionId overrides_version = 0;
+    if (cfg_document != document) {
+        cfg_document->mutex.ReaderLock();
+        overrides_version = get_overrides_version_locked(cfg_document, version);
+        cfg_document->mutex.ReaderUnlock();
+    }
+
+    document->mutex.ReaderLock();
+    bool found = false;
+    if (document->oldest_version <= version) {
+        overrides_version = std::max(
+            overrides_version,
+            get_overrides_version_locked(document, version)
+        );
+        if (
+            auto search = document->overrides_key_by_labels.find(
+                overrides_labels_ref_t(overrides_version, &labels)
+            );
+            search != document->overrides_key_by_labels.end()
+        ) {
+            overrides_key = search->second;
+            found = true;
+        }
+    }
+    document->mutex.ReaderUnlock();
+
+    if (found) {
+        return true;
+    }
+
+    overrides_key.clear();
+    bool is_a_valid_version = for_each_document_override(
+        config,
+        document,
+        labels,
+        version,
+        [&overrides_key](auto&& raw_config) {
+            jmutils::push_uint16(overrides_key, raw_config->id);
+        }
+    );
+
+    if (is_a_valid_version) {
+        document->mutex.Lock();
+        if (document->oldest_version <= version) {
+            // Only one key is evicted to avoid build all the keys again
+            if (document->overrides_key_by_labels.size() >= MAX_OVERRIDES_KEYS_BY_LABELS) {
+                document->overrides_key_by_labels.erase(
+                    document->overrides_key_by_labels.begin()
+                );
+            }
+            document->overrides_key_by_labels.emplace(
+                overrides_labels_t(overrides_version, labels),
+                overrides_key
+            );
+        }
+        document->mutex.Unlock();
+    }
+
+    return is_a_valid_version;
+}
+
 std::shared_ptr<merged_config_t> get_or_build_merged_config(
     document_t* document,
     const std::string& overrides_key
@@ -793,6 +910,28 @@ CheckMergedConfigResult check_merged_config(
     std::shared_ptr<GetConfigTask>& task,
     bool has_exclusive_lock
 ) {
+    switch (merged_config->status) {
+        case MergedConfigStatus::UNDEFINED: // Fallback
+        case MergedConfigStatus::BUILDING:
+            break;
+        case MergedConfigStatus::NO_OPTIMIZED: // Fallback
+        case MergedConfigStatus::OPTIMIZING: // Fallback
+        case MergedConfigStatus::OPTIMIZED: // Fallback
+        case MergedConfigStatus::OPTIMIZATION_FAIL:
+            // The logs are obtained building again the config without cache it
+            if (task->log_level() > merged_config->log_level) {
+                if (!has_exclusive_lock) {
+                    return CheckMergedConfigResult::NEED_EXCLUSIVE_LOCK;
+                }
+                spdlog::debug(
+                    "The built document '{}' hasn't the asked logs",
+                    task->document()
+                );
+                return CheckMergedConfigResult::BUILD_CONFIG;
+            }
+            break;
+    }
+
     switch (merged_config->status) {
         case MergedConfigStatus::UNDEFINED:
             if (!has_exclusive_lock) {
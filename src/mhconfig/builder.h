@@ -6,6 +6,7 @@
 #include <stddef.h>
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <filesystem>
 #include <fstream>
 #include <iterator>
@@ -14,6 +15,7 @@
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <thread>
 #include <utility>
 #include <vector>
 #include <openssl/sha.h>
@@ -42,6 +44,7 @@
 #include "mhconfig/logger/spdlog_logger.h"
 #include "mhconfig/logger/bi_logger.h"
 #include "mhconfig/element_builder.h"
+#include "mhconfig/worker/parallel_command.h"
 
 namespace mhconfig
 {
@@ -63,6 +66,7 @@ struct load_raw_config_result_t {
 };
 
 bool init_config_namespace(
+    context_t* ctx,
     config_namespace_t* cn
 );
 
@@ -150,14 +154,27 @@ std::optional<Labels> get_path_labels(
     const std::filesystem::path& path
 );
 
+// Index the files in parallel using the worker threads, the results keep
+// the order of the paths
+bool index_files_in_parallel(
+    context_t* ctx,
+    jmutils::string::Pool* pool,
+    const std::filesystem::path& root_path,
+    const std::vector<std::filesystem::path>& paths,
+    std::vector<load_raw_config_result_t>& results
+);
+
 template <typename T>
 bool index_files(
+    context_t* ctx,
     jmutils::string::Pool* pool,
     const std::filesystem::path& root_path,
     T lambda
 ) {
     spdlog::debug("To index the files in the path '{}'", root_path.string());
 
+    std::vector<std::filesystem::path> paths;
+
     std::error_code error_code;
     for (
         std::filesystem::recursive_directory_iterator it(root_path, error_code), end;
@@ -167,26 +184,7 @@ bool index_files(
         if (it->path().filename().native()[0] == '.') {
             it.disable_recursion_pending();
         } else if (it->is_regular_file()) {
-            auto result = index_file(pool, root_path, it->path());
-            if (result.status != LoadRawConfigStatus::INVALID_FILENAME) {
-                auto relative_path = std::filesystem::relative(it->path(), root_path)
-                    .parent_path();
-
-                auto labels = get_path_labels(relative_path);
-
-                bool ok = labels.has_value();
-                if (ok) {
-                    ok = lambda(std::move(labels.value()), std::move(result));
-                }
-
-                if (!ok) {
-                    spdlog::error(
-                        "Some error take place processing the file '{}'",
-                        it->path().string()
-                    );
-                    return false;
-                }
-            }
+            paths.push_back(it->path());
         }
     }
 
@@ -196,9 +194,42 @@ bool index_files(
             root_path.string(),
             error_code.message()
         );
+        return false;
+    }
+
+    // The parse of the files is done in parallel but the results are
+    // processed in the iteration order to assign always the same ids
+    std::vector<load_raw_config_result_t> results;
+    if (!index_files_in_parallel(ctx, pool, root_path, paths, results)) {
+        spdlog::error(
+            "Some error take place indexing the files on '{}'",
+            root_path.string()
+        );
+        return false;
     }
+    for (size_t i = 0, l = paths.size(); i < l; ++i) {
+        if (results[i].status != LoadRawConfigStatus::INVALID_FILENAME) {
+            auto relative_path = std::filesystem::relative(paths[i], root_path)
+                .parent_path();
 
-    return !error_code;
+            auto labels = get_path_labels(relative_path);
+
+            bool ok = labels.has_value();
+            if (ok) {
+                ok = lambda(std::move(labels.value()), std::move(results[i]));
+            }
+
+            if (!ok) {
+                spdlog::error(
+                    "Some error take place processing the file '{}'",
+                    paths[i].string()
+                );
+                return false;
+            }
+        }
+    }
+
+    return true;
 }
 
 enum class AffectedDocumentStatus {
@@ -373,6 +404,25 @@ bool for_each_document_override(
     return is_a_valid_version;
 }
 
+// The last version previous or equal to the asked one that changed some
+// override of the document
+VersionId get_overrides_version_locked(
+    document_t* document,
+    VersionId version
+);
+
+// Obtain the identifiers of the raw configs to merge for some labels,
+// the result is cached by the last version that changed the overrides
+// of the document or the config document since it can't change
+bool get_overrides_key(
+    const Element& config,
+    document_t* cfg_document,
+    document_t* document,
+    const Labels& labels,
+    VersionId version,
+    std::string& overrides_key
+);
+
 bool alloc_payload_locked(
     merged_config_t* merged_config
 );
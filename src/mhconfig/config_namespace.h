@@ -2,6 +2,7 @@
 #define MHCONFIG__CONFIG_NAMESPACE_H
 
 #include <absl/container/btree_map.h>
+#include <absl/container/btree_set.h>
 #include <absl/container/flat_hash_map.h>
 #include <absl/synchronization/mutex.h>
 #include <atomic>
@@ -75,6 +76,8 @@ struct raw_config_t {
   }
 };
 
+struct merged_config_t;
+
 class GetConfigTask
 {
 public:
@@ -94,9 +97,24 @@ public:
     void* payload
   ) = 0;
 
+  // Complete the task with the pre-encoded responses of the merged config,
+  // returning false if it isn't possible
+  virtual bool on_complete_encoded(
+    std::shared_ptr<config_namespace_t>& cn,
+    VersionId version,
+    merged_config_t* merged_config
+  ) {
+    return false;
+  }
+
   virtual Logger& logger() = 0;
 
   virtual ReplayLogger::Level log_level() const = 0;
+
+  // The internal tasks don't trigger the traces of the asked config
+  virtual bool is_traceable() const {
+    return true;
+  }
 };
 
 class PolicyCheck
@@ -123,10 +141,12 @@ enum class MergedConfigStatus : uint8_t {
 };
 
 struct document_t;
-struct merged_config_t;
 
 struct build_element_t {
   bool to_build{false};
+  // The merged config isn't cached, it's only built to obtain the logs
+  bool detached{false};
+  std::string overrides_key;
   mhconfig::Element config;
   std::shared_ptr<document_t> document;
   std::shared_ptr<merged_config_t> merged_config;
@@ -136,6 +156,7 @@ struct build_element_t {
 struct pending_build_t {
   std::atomic<uint32_t> num_pending;
   VersionId version;
+  ReplayLogger::Level log_level{ReplayLogger::Level::error};
   std::shared_ptr<GetConfigTask> task;
   LinkedList<build_element_t> elements;
 };
@@ -145,10 +166,15 @@ struct merged_config_payload_fun_t {
   void (*dealloc)(void*);
 };
 
+// The cached merged configs only keep the error and warning logs
+constexpr size_t NUM_ENCODED_LOG_LEVELS = 2;
+
 struct merged_config_t {
   absl::Mutex mutex;
   MergedConfigStatus status : 8;
-  uint64_t creation_timestamp : 56;
+  // The greater level of the stored logs
+  ReplayLogger::Level log_level : 8;
+  uint64_t creation_timestamp : 48;
   uint64_t last_access_timestamp;
   Element value;
   std::array<uint8_t, 32> checksum;
@@ -158,6 +184,21 @@ struct merged_config_t {
   void* payload;
   merged_config_payload_fun_t payload_fun;
 
+  // The elements encoded by response type & with_position once it's optimized
+  std::array<
+    std::shared_ptr<const api::encoded_elements_t>,
+    2*api::NUM_RESPONSE_TYPES
+  > encoded_elements;
+  // The logs & sources encoded like the elements, also by the asked level
+  std::array<
+    std::shared_ptr<const api::encoded_logs_t>,
+    2*api::NUM_RESPONSE_TYPES*NUM_ENCODED_LOG_LEVELS
+  > encoded_logs;
+  // The bytes of the encoded responses, reported to the metrics while
+  // the merged config is alive
+  Metrics* metrics;
+  size_t encoded_bytes;
+
   // Change this to a shared_ptr (?)
   absl::flat_hash_set<std::string> reference_to;
 
@@ -168,23 +209,86 @@ struct merged_config_t {
 
   merged_config_t()
     : status(MergedConfigStatus::UNDEFINED),
+    log_level(ReplayLogger::Level::trace),
     creation_timestamp(0),
     last_access_timestamp(0),
     checksum(UNDEFINED_ELEMENT_CHECKSUM),
-    payload(nullptr)
+    payload(nullptr),
+    metrics(nullptr),
+    encoded_bytes(0)
   {}
 
   ~merged_config_t() {
     if (payload != nullptr) {
       payload_fun.dealloc(payload);
     }
+    if ((metrics != nullptr) && (encoded_bytes != 0)) {
+      metrics->add(
+        Metrics::Id::OPTIMIZED_MERGED_CONFIG_USED_BYTES,
+        {},
+        -static_cast<double>(encoded_bytes)
+      );
+    }
   }
 };
 
+// The not finished merge of the first raw configs of a override chain
+struct merge_prefix_t {
+  Element value;
+  MultiPersistentLogger logger;
+};
+
+// The merge of the values of a root key in the raw configs that have it
+struct merged_key_t {
+  bool removed{false};
+  Element value;
+  MultiPersistentLogger logger;
+};
+
 struct override_t {
   absl::btree_map<VersionId, std::shared_ptr<raw_config_t>> raw_config_by_version;
 };
 
+// The overrides of some labels are keyed by the version of the overrides
+// that was used, the lookups use a pointer to the asked labels to avoid
+// copy them
+typedef std::pair<VersionId, Labels> overrides_labels_t;
+typedef std::pair<VersionId, const Labels*> overrides_labels_ref_t;
+
+struct overrides_labels_hash_t {
+  using is_transparent = void;
+
+  size_t operator()(const overrides_labels_t& key) const {
+    return hash(key.first, key.second);
+  }
+
+  size_t operator()(const overrides_labels_ref_t& key) const {
+    return hash(key.first, *key.second);
+  }
+
+  static size_t hash(VersionId version, const Labels& labels) {
+    size_t h = absl::Hash<Labels>()(labels);
+    boost::hash_combine(h, version);
+    return h;
+  }
+};
+
+struct overrides_labels_eq_t {
+  using is_transparent = void;
+
+  bool operator()(const overrides_labels_t& lhs, const overrides_labels_t& rhs) const {
+    return (lhs.first == rhs.first) && (lhs.second == rhs.second);
+  }
+
+  bool operator()(const overrides_labels_t& lhs, const overrides_labels_ref_t& rhs) const {
+    return (lhs.first == rhs.first) && (lhs.second == *rhs.second);
+  }
+
+  bool operator()(const overrides_labels_ref_t& lhs, const overrides_labels_t& rhs) const {
+    return (lhs.first == rhs.first) && (*lhs.second == rhs.second);
+  }
+};
+
 struct merged_config_generation_t {
   absl::Mutex gc_mutex;
   std::shared_ptr<merged_config_t> head;
@@ -204,6 +308,37 @@ struct document_t {
     std::weak_ptr<merged_config_t>
   > merged_config_by_overrides_key;
 
+  // The versions that changed some override of the document
+  absl::btree_set<VersionId> overrides_versions;
+
+  // The overrides key of the asked labels by the version of the overrides,
+  // so it's only invalidated by the changes of this document
+  absl::flat_hash_map<
+    overrides_labels_t,
+    std::string,
+    overrides_labels_hash_t,
+    overrides_labels_eq_t
+  > overrides_key_by_labels;
+
+  // The merge prefixes keyed by the ids of the merged raw configs,
+  // the different chains usually only differ in the last overrides
+  absl::flat_hash_map<
+    std::string,
+    std::shared_ptr<merge_prefix_t>
+  > merge_prefix_by_key;
+
+  // The merged root keys keyed by the key and the ids of his sources,
+  // in that way a update only merge again the keys of the changed files
+  absl::flat_hash_map<
+    std::string,
+    std::shared_ptr<merged_key_t>
+  > merged_key_by_sources;
+
+  // The document that was migrated to this one compacting the raw config
+  // ids and the previous id of the migrated raw configs
+  std::weak_ptr<document_t> migrated_from;
+  absl::flat_hash_map<RawConfigId, RawConfigId> migrated_raw_config_ids;
+
   merged_config_payload_fun_t mc_payload_fun;
 
   std::string name;
@@ -273,6 +408,8 @@ struct context_t {
   WorkerQueue worker_queue;
   Metrics metrics;
   std::string mhc_root_path;
+  // The position of the next namespace to compact the string pool
+  std::atomic<size_t> gc_string_pools_cursor{0};
 };
 
 class WorkerCommand
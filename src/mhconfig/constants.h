@@ -1,6 +1,7 @@
 #ifndef MHCONFIG__CONSTANTS_H
 #define MHCONFIG__CONSTANTS_H
 
+#include <stddef.h>
 #include <string>
 
 namespace mhconfig
@@ -23,6 +24,12 @@ const static std::string TAG_OVERRIDE{"!override"};
 const static std::string TAG_MERGE{"!merge"};
 
 const static uint8_t NUMBER_OF_MC_GENERATIONS{3};
+const static size_t MAX_OVERRIDES_KEYS_BY_LABELS{4096};
+const static size_t MAX_MERGE_PREFIXES_BY_DOCUMENT{4096};
+const static size_t MAX_MERGED_KEYS_BY_DOCUMENT{65536};
+const static size_t MAX_PREWARMED_MERGED_CONFIGS{256};
+const static uint64_t PREWARM_MERGED_CONFIGS_TIMEOUT_MS{2000};
+const static uint64_t PREWARM_MERGED_CONFIG_ACCESS_TIMELIMIT_S{300};
 
 const static std::string DOCUMENT_NAME_TOKENS{"tokens"};
 const static std::string DOCUMENT_NAME_POLICY{"policy"};
@@ -1,5 +1,7 @@
 #include "mhconfig/element.h"
 
+#include <openssl/bn.h>
+
 namespace mhconfig {
     std::string to_string(Element::Type type) {
         switch (type) {
@@ -200,17 +202,28 @@ namespace mhconfig {
     void Element::freeze() {
         switch (type_) {
             case Type::MAP:
-                data_.map.freeze([](auto* map) {
-                    map->rehash(0);
-                    for (auto& it: *map) it.second.freeze();
+                data_.map.freeze([](auto* map, auto* metadata) {
+                    // Only the nodes modified since the last freeze are visited
+                    auto root = map->freeze([](auto values, auto children, auto& node) {
+                        for (auto& it : values) {
+                            it.second.freeze();
+                        }
+                        make_map_node_metadata(values, children, node);
+                    });
+                    metadata->tags = root.tags;
+                    make_map_digest(map->size(), root, metadata->digest);
                 });
                 break;
             case Type::SEQUENCE:
-                data_.seq.freeze([](auto* seq) {
-                    seq->shrink_to_fit();
-                    for (size_t i = 0, l = seq->size(); i < l; ++i) {
-                        (*seq)[i].freeze();
-                    }
+                data_.seq.freeze([](auto* seq, auto* metadata) {
+                    auto root = seq->freeze([](auto values, auto children, auto& node) {
+                        for (auto& e : values) {
+                            e.freeze();
+                        }
+                        make_seq_node_metadata(values, children, node);
+                    });
+                    metadata->tags = root.tags;
+                    make_seq_digest(seq->size(), root, metadata->digest);
                 });
                 break;
             default:
@@ -218,17 +231,48 @@ namespace mhconfig {
         }
     }
 
+    bool Element::may_contain_tags(uint8_t mask) const {
+        switch (type_) {
+            case Type::MAP: {
+                auto metadata = data_.map.metadata();
+                return !data_.map.is_frozen() || ((metadata != nullptr) && (metadata->tags & mask));
+            }
+            case Type::SEQUENCE: {
+                auto metadata = data_.seq.metadata();
+                return !data_.seq.is_frozen() || ((metadata != nullptr) && (metadata->tags & mask));
+            }
+            default:
+                break;
+        }
+        return false;
+    }
+
+    uint8_t Element::subtree_tags() const {
+        uint8_t result = tag_ == Tag::NONE ? 0 : tag_mask(tag_);
+        switch (type_) {
+            case Type::MAP:
+                if (auto metadata = data_.map.metadata(); metadata != nullptr) {
+                    result |= metadata->tags;
+                }
+                break;
+            case Type::SEQUENCE:
+                if (auto metadata = data_.seq.metadata(); metadata != nullptr) {
+                    result |= metadata->tags;
+                }
+                break;
+            default:
+                break;
+        }
+        return result;
+    }
+
     std::array<uint8_t, 32> Element::make_checksum() const {
         std::string fingerprint;
-        jmutils::push_varint(fingerprint, 1); // fingerprint & checksum version
+        jmutils::push_varint(fingerprint, 4); // fingerprint & checksum version
         add_fingerprint(fingerprint);
 
         std::array<uint8_t, 32> checksum;
-
-        SHA256_CTX sha256;
-        SHA256_Init(&sha256);
-        SHA256_Update(&sha256, fingerprint.data(), fingerprint.size());
-        SHA256_Final(checksum.data(), &sha256);
+        make_digest(fingerprint, checksum);
 
         return checksum;
     }
@@ -239,39 +283,51 @@ namespace mhconfig {
 
         switch (type_) {
             case Type::MAP: {
-                auto map = data_.map.get();
-                std::vector<std::pair<std::string, Element>> sorted_values;
-                sorted_values.reserve(map->size());
-                for (const auto& it: *map) {
-                    sorted_values.emplace_back(it.first.str(), it.second);
-                }
-                std::sort(
-                    sorted_values.begin(),
-                    sorted_values.end(),
-                    [](const auto& a, const auto& b) { return a.first < b.first; }
-                );
-
-                jmutils::push_varint(output, map->size());
-                for (size_t i = 0, l = sorted_values.size(); i < l; ++i) {
-                    jmutils::push_str(output, sorted_values[i].first);
-                    sorted_values[i].second.add_fingerprint(output);
+                // A moved map hasn't payload, so neither the cached digest
+                auto metadata = data_.map.metadata();
+                if (data_.map.is_frozen() && (metadata != nullptr)) {
+                    const auto& digest = metadata->digest;
+                    output.append((const char*) digest.data(), digest.size());
+                } else {
+                    std::array<uint8_t, 32> digest;
+                    if (auto map = data_.map.get(); map != nullptr) {
+                        auto root = map->make_metadata(make_map_node_metadata);
+                        make_map_digest(map->size(), root, digest);
+                    } else {
+                        make_map_digest(0, Map().make_metadata(make_map_node_metadata), digest);
+                    }
+                    output.append((const char*) digest.data(), digest.size());
                 }
                 break;
             }
 
             case Type::SEQUENCE: {
-                auto seq = data_.seq.get();
-                jmutils::push_varint(output, seq->size());
-                for (const auto& x: *seq) {
-                    x.add_fingerprint(output);
+                auto metadata = data_.seq.metadata();
+                if (data_.seq.is_frozen() && (metadata != nullptr)) {
+                    const auto& digest = metadata->digest;
+                    output.append((const char*) digest.data(), digest.size());
+                } else {
+                    std::array<uint8_t, 32> digest;
+                    if (auto seq = data_.seq.get(); seq != nullptr) {
+                        auto root = seq->make_metadata(make_seq_node_metadata);
+                        make_seq_digest(seq->size(), root, digest);
+                    } else {
+                        make_seq_digest(0, Seq().make_metadata(make_seq_node_metadata), digest);
+                    }
+                    output.append((const char*) digest.data(), digest.size());
                 }
                 break;
             }
 
             case Type::BIN: // Fallback
-            case Type::STR:
-                jmutils::push_str(output, data_.literal.str());
+            case Type::STR: {
+                size_t size = data_.literal.size();
+                jmutils::push_varint(output, size);
+                size_t offset = output.size();
+                output.resize(offset + size);
+                data_.literal.to_chars(&output[offset], &output[offset] + size);
                 break;
+            }
 
             case Type::INT64:
                 jmutils::push_uint64(output, data_.uint64_value);
@@ -287,6 +343,141 @@ namespace mhconfig {
         }
     }
 
+    // The context of the big numbers of the multiset hash of the map nodes,
+    // it's allocated once by thread and every call takes his numbers from
+    // a new frame, since the fingerprint of a value could compute the
+    // metadata of the nodes of a nested map
+    struct muhash_context_t {
+        BN_CTX* ctx;
+        BIGNUM* prime;
+
+        muhash_context_t()
+            : ctx(BN_CTX_new()),
+            prime(BN_get_rfc3526_prime_2048(nullptr))
+        {
+        }
+
+        ~muhash_context_t() {
+            BN_free(prime);
+            BN_CTX_free(ctx);
+        }
+    };
+
+    static muhash_context_t& get_muhash_context() {
+        thread_local muhash_context_t context;
+        return context;
+    }
+
+    // Expand the digest of an entry to an element of the multiplicative
+    // group of the prime
+    static void muhash_element(
+        muhash_context_t& context,
+        const std::array<uint8_t, 32>& digest,
+        BIGNUM* value
+    ) {
+        std::array<uint8_t, 256> bytes;
+        std::array<uint8_t, 33> input;
+        std::copy(digest.begin(), digest.end(), input.begin());
+        for (size_t i = 0; i < bytes.size()/SHA256_DIGEST_LENGTH; ++i) {
+            input.back() = i;
+            SHA256(input.data(), input.size(), &bytes[i*SHA256_DIGEST_LENGTH]);
+        }
+
+        BN_bin2bn(bytes.data(), bytes.size(), value);
+        BN_mod(value, value, context.prime, context.ctx);
+        if (BN_is_zero(value)) {
+            BN_one(value);
+        }
+    }
+
+    void Element::make_map_node_metadata(
+        absl::Span<const Map::value_type> values,
+        absl::Span<const map_node_metadata_t* const> children,
+        map_node_metadata_t& metadata
+    ) {
+        auto& context = get_muhash_context();
+        BN_CTX_start(context.ctx);
+        BIGNUM* product = BN_CTX_get(context.ctx);
+        BIGNUM* value = BN_CTX_get(context.ctx);
+        BN_one(product);
+        metadata.tags = 0;
+
+        std::string fingerprint;
+        std::array<uint8_t, 32> digest;
+        for (const auto& it : values) {
+            jmutils::string::PinnedString key(it.first);
+            fingerprint.clear();
+            jmutils::push_str(fingerprint, key.view());
+            it.second.add_fingerprint(fingerprint);
+            make_digest(fingerprint, digest);
+            muhash_element(context, digest, value);
+            BN_mod_mul(product, product, value, context.prime, context.ctx);
+            metadata.tags |= it.second.subtree_tags();
+        }
+
+        for (const auto* child : children) {
+            BN_bin2bn(child->product.data(), child->product.size(), value);
+            BN_mod_mul(product, product, value, context.prime, context.ctx);
+            metadata.tags |= child->tags;
+        }
+
+        BN_bn2binpad(product, metadata.product.data(), metadata.product.size());
+        BN_CTX_end(context.ctx);
+    }
+
+    void Element::make_seq_node_metadata(
+        absl::Span<const Element> values,
+        absl::Span<const container_metadata_t* const> children,
+        container_metadata_t& metadata
+    ) {
+        metadata.tags = 0;
+
+        std::string fingerprint;
+        for (const auto& e : values) {
+            e.add_fingerprint(fingerprint);
+            metadata.tags |= e.subtree_tags();
+        }
+
+        for (const auto* child : children) {
+            fingerprint.append((const char*) child->digest.data(), child->digest.size());
+            metadata.tags |= child->tags;
+        }
+
+        make_digest(fingerprint, metadata.digest);
+    }
+
+    void Element::make_map_digest(
+        size_t size,
+        const map_node_metadata_t& root,
+        std::array<uint8_t, 32>& digest
+    ) {
+        std::string fingerprint;
+        jmutils::push_varint(fingerprint, size);
+        fingerprint.append((const char*) root.product.data(), root.product.size());
+        make_digest(fingerprint, digest);
+    }
+
+    void Element::make_seq_digest(
+        size_t size,
+        const container_metadata_t& root,
+        std::array<uint8_t, 32>& digest
+    ) {
+        std::string fingerprint;
+        jmutils::push_varint(fingerprint, size);
+        fingerprint.append((const char*) root.digest.data(), root.digest.size());
+        make_digest(fingerprint, digest);
+    }
+
+    void Element::make_digest(
+        const std::string& fingerprint,
+        std::array<uint8_t, 32>& digest
+    ) {
+        SHA256_CTX sha256;
+        SHA256_Init(&sha256);
+        SHA256_Update(&sha256, fingerprint.data(), fingerprint.size());
+        SHA256_Final(digest.data(), &sha256);
+    }
+
     std::optional<std::string> Element::to_yaml() const {
         YAML::Emitter out;
         out.SetIndent(2);
@@ -21,7 +21,10 @@
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/hash/hash.h"
+#include "absl/types/span.h"
 #include "jmutils/common.h"
+#include "jmutils/container/persistent_map.h"
+#include "jmutils/container/persistent_vector.h"
 #include "jmutils/cow.h"
 #include "jmutils/string/pool.h"
 #include "mhconfig/constants.h"
@@ -34,9 +37,30 @@
 namespace mhconfig {
     class Element;
 
+    // The metadata of a frozen container or of a frozen sequence node, the
+    // digest of a sequence node is the digest of his values in order
+    struct container_metadata_t {
+        std::array<uint8_t, 32> digest{};
+        // Mask of the tags of the descendants
+        uint8_t tags{0};
+    };
+
+    // The metadata of a frozen map node, the product is the multiset hash
+    // (MuHash) of the entries of his subtree, the product modulo the 2048
+    // bits prime of the RFC 3526 of a hash of every entry, so it doesn't
+    // depend of the shape of the trie and to find a collision is as hard
+    // as the discrete logarithm
+    struct map_node_metadata_t {
+        std::array<uint8_t, 256> product{};
+        // Mask of the tags of the descendants
+        uint8_t tags{0};
+    };
+
     typedef jmutils::string::String Literal;
-    typedef absl::flat_hash_map<jmutils::string::String, Element> Map;
-    typedef std::vector<Element> Seq;
+    // The containers share the nodes with his copies, so the override of
+    // a frozen container only copy the nodes of the modified paths
+    typedef jmutils::container::PersistentMap<Literal, Element, map_node_metadata_t> Map;
+    typedef jmutils::container::PersistentVector<Element, container_metadata_t> Seq;
 
     namespace conversion
     {
@@ -224,6 +248,14 @@ namespace mhconfig {
 
         void freeze();
 
+        inline static constexpr uint8_t tag_mask(Tag tag) {
+            return 1 << static_cast<uint8_t>(tag);
+        }
+
+        // Check if some descendant of the element could have some of the
+        // tags of the mask, only the frozen containers know their tags
+        bool may_contain_tags(uint8_t mask) const;
+
         template <typename F>
         void walk_mut(F lambda) {
             lambda(this);
@@ -252,8 +284,8 @@ namespace mhconfig {
         template <typename T>
         friend std::optional<T> conversion::as(const Element& e);
 
-        typedef jmutils::Cow<Map> MapData;
-        typedef jmutils::Cow<Seq> SeqData;
+        typedef jmutils::Cow<Map, container_metadata_t> MapData;
+        typedef jmutils::Cow<Seq, container_metadata_t> SeqData;
 
         union data_t {
             MapData map;
@@ -288,6 +320,31 @@ namespace mhconfig {
 
         void add_fingerprint(std::string& output) const;
 
+        uint8_t subtree_tags() const;
+
+        static void make_map_node_metadata(
+            absl::Span<const Map::value_type> values,
+            absl::Span<const map_node_metadata_t* const> children,
+            map_node_metadata_t& metadata
+        );
+        static void make_seq_node_metadata(
+            absl::Span<const Element> values,
+            absl::Span<const container_metadata_t* const> children,
+            container_metadata_t& metadata
+        );
+
+        static void make_map_digest(
+            size_t size,
+            const map_node_metadata_t& root,
+            std::array<uint8_t, 32>& digest
+        );
+        static void make_seq_digest(
+            size_t size,
+            const container_metadata_t& root,
+            std::array<uint8_t, 32>& digest
+        );
+        static void make_digest(const std::string& fingerprint, std::array<uint8_t, 32>& digest);
+
         bool to_yaml_base(YAML::Emitter& out) const;
     };
 
@@ -15,6 +15,11 @@ ElementBuilder::ElementBuilder(
 {
 }
 
+Element ElementBuilder::build(YAML::Node &node) {
+    intern_strings(node);
+    return make_and_check(node);
+}
+
 Element ElementBuilder::make_and_check(YAML::Node &node) {
     auto element = make(node);
 
@@ -89,7 +94,7 @@ Element ElementBuilder::make_from_scalar(YAML::Node &node) {
         return make_element_and_trace(
             "Created string value",
             node,
-            pool_->add(node.as<std::string>())
+            add_string(node.Scalar())
         );
     } else if (node.Tag() == TAG_PLAIN_SCALAR) {
         return make_from_plain_scalar(node);
@@ -148,7 +153,7 @@ Element ElementBuilder::make_from_scalar(YAML::Node &node) {
         Element element = make_element_and_trace(
             "Created string value with a override tag",
             node,
-            pool_->add(node.as<std::string>())
+            add_string(node.Scalar())
         );
         element.set_tag(Element::Tag::OVERRIDE);
         return element;
@@ -158,38 +163,53 @@ Element ElementBuilder::make_from_scalar(YAML::Node &node) {
 }
 
 Element ElementBuilder::make_from_plain_scalar(YAML::Node &node) {
-    Element e = make_from_bool(node);
-    if (!e.is_undefined()) {
-        logger_.trace("Created bool value from plain scalar", e);
-        return e;
-    }
-
-    e = make_from_int64(node);
-    if (!e.is_undefined()) {
-        logger_.trace("Created int64 value from plain scalar", e);
-        return e;
-    }
-
-    e = make_from_double(node);
-    if (!e.is_undefined()) {
-        logger_.trace("Created double value from plain scalar", e);
-        return e;
+    const auto& str = node.Scalar();
+    auto scalar = classify_plain_scalar(str);
+    switch (scalar.type) {
+        case Element::Type::BOOL:
+            return make_element_and_trace(
+                "Created bool value from plain scalar",
+                node,
+                scalar.bool_value
+            );
+        case Element::Type::INT64:
+            return make_element_and_trace(
+                "Created int64 value from plain scalar",
+                node,
+                scalar.int64_value
+            );
+        case Element::Type::DOUBLE:
+            return make_element_and_trace(
+                "Created double value from plain scalar",
+                node,
+                scalar.double_value
+            );
+        default:
+            break;
     }
 
     return make_element_and_trace(
         "Created string value from plain scalar",
         node,
-        pool_->add(node.as<std::string>())
+        add_string(str)
     );
 }
 
 Element ElementBuilder::make_from_format(YAML::Node &node) {
     Element element = make_element(node);
+    // The first value is a sequence with the size of all the literals
+    // followed by the indexes of the references, so the render only have
+    // to compute the size of the referenced values
     Seq tmpl_seq;
+    tmpl_seq.push_back(Element());
+    Seq hint_seq;
+    hint_seq.push_back(Element());
+    int64_t literals_size = 0;
 
-    auto tmpl = node.as<std::string>();
+    const auto& tmpl = node.Scalar();
+    std::string literal;
     for (size_t i = 0, l = tmpl.size(); i < l; ++i) {
-        std::stringstream ss;
+        literal.clear();
         for (;i < l; ++i) {
             if (tmpl[i] == '{') {
                 if (++i >= l) {
@@ -205,11 +225,12 @@ Element ElementBuilder::make_from_format(YAML::Node &node) {
                     return element;
                 }
             }
-            ss << tmpl[i];
+            literal.push_back(tmpl[i]);
         }
 
-        if (auto x = ss.str(); !x.empty()) {
-            tmpl_seq.push_back(make_element(node, pool_->add(x)));
+        if (!literal.empty()) {
+            literals_size += literal.size();
+            tmpl_seq.push_back(make_element(node, add_string(literal)));
         }
 
         if (i < l) {
@@ -221,7 +242,7 @@ Element ElementBuilder::make_from_format(YAML::Node &node) {
                 } else {
                     tag = Element::Tag::REF;
                     arg_seq.push_back(
-                        make_element(node, pool_->add(*slice))
+                        make_element(node, add_string(*slice))
                     );
                     reference_to_.insert(*slice);
                 }
@@ -232,7 +253,7 @@ Element ElementBuilder::make_from_format(YAML::Node &node) {
             while ((i < l) && (tmpl[i] != '}')) {
                 if (auto slice = parse_format_slice(element, tmpl, ++i)) {
                     arg_seq.push_back(
-                        make_element(node, pool_->add(*slice))
+                        make_element(node, add_string(*slice))
                     );
                 } else {
                     return element;
@@ -241,10 +262,13 @@ Element ElementBuilder::make_from_format(YAML::Node &node) {
 
             Element e(std::move(arg_seq));
             e.set_tag(tag);
+            hint_seq.push_back(make_element(node, (int64_t) tmpl_seq.size()));
             tmpl_seq.push_back(std::move(e.set_origin(element)));
         }
     }
 
+    hint_seq[0] = make_element(node, literals_size);
+    tmpl_seq[0] = make_element(node, std::move(hint_seq));
     element = make_element_and_trace(
         "Created template",
         node,
@@ -255,43 +279,33 @@ Element ElementBuilder::make_from_format(YAML::Node &node) {
 }
 
 Element ElementBuilder::make_from_int64(YAML::Node &node) {
-    auto str(node.as<std::string>());
-    char *end;
-    errno = 0;
-    int64_t value = std::strtoll(str.c_str(), &end, 10);
-    return errno || (str.c_str() == end) || (*end != 0)
-        ? make_element(node)
-        : make_element(node, value);
+    int64_t value;
+    return parse_int64(node.Scalar(), value)
+        ? make_element(node, value)
+        : make_element(node);
 }
 
 Element ElementBuilder::make_from_double(YAML::Node &node) {
-    auto str(node.as<std::string>());
-    char *end;
-    errno = 0;
-    double value = std::strtod(str.c_str(), &end);
-    return errno || (str.c_str() == end) || (*end != 0)
-        ? make_element(node)
-        : make_element(node, value);
+    double value;
+    return parse_double(node.Scalar(), value)
+        ? make_element(node, value)
+        : make_element(node);
 }
 
 Element ElementBuilder::make_from_bool(YAML::Node &node) {
-    auto str(node.as<std::string>());
-    if (str == "true") {
-        return make_element(node, true);
-    } else if (str == "false") {
-        return make_element(node, false);
-    }
-    return make_element(node);
+    bool value;
+    return parse_bool(node.Scalar(), value)
+        ? make_element(node, value)
+        : make_element(node);
 }
 
 Element ElementBuilder::make_from_map(YAML::Node &node) {
     Map map;
-    map.reserve(node.size());
     for (auto it : node) {
         if (!it.first.IsScalar()) {
             return make_element_and_error("The key of a map must be a scalar", node);
         }
-        jmutils::string::String key(pool_->add(it.first.as<std::string>()));
+        jmutils::string::String key(add_string(it.first.Scalar()));
         auto value = make_and_check(it.second);
         auto key_mark = it.first.Mark();
         value.set_position(key_mark.line, key_mark.column);
@@ -315,7 +329,6 @@ Element ElementBuilder::make_from_map(YAML::Node &node) {
 
 Element ElementBuilder::make_from_seq(YAML::Node &node) {
     Seq seq;
-    seq.reserve(node.size());
     for (auto it : node) {
         seq.push_back(make_and_check(it));
     }
@@ -363,6 +376,109 @@ Element ElementBuilder::make_from_seq(YAML::Node &node) {
     return make_element_and_error("Unknown tag for a sequence value", node);
 }
 
+void ElementBuilder::intern_strings(YAML::Node &node) {
+    std::vector<std::string> strs;
+    collect_strings(node, strs);
+
+    std::vector<jmutils::string::String> interned;
+    pool_->add(strs, interned);
+    for (size_t i = 0, l = strs.size(); i < l; ++i) {
+        strings_[strs[i]] = std::move(interned[i]);
+    }
+}
+
+void ElementBuilder::collect_strings(
+    YAML::Node &node,
+    std::vector<std::string>& strs
+) {
+    switch (node.Type()) {
+        case YAML::NodeType::Scalar: {
+            if (
+                (node.Tag() == TAG_NON_PLAIN_SCALAR)
+                || (node.Tag() == TAG_STR)
+                || (node.Tag() == TAG_OVERRIDE)
+                || (node.Tag() == TAG_PLAIN_SCALAR)
+            ) {
+                const auto& str = node.Scalar();
+                if (
+                    (
+                        (node.Tag() != TAG_PLAIN_SCALAR)
+                        || (classify_plain_scalar(str).type == Element::Type::STR)
+                    )
+                    && strings_.try_emplace(str).second
+                ) {
+                    strs.push_back(str);
+                }
+            }
+            break;
+        }
+        case YAML::NodeType::Sequence:
+            for (auto it : node) {
+                collect_strings(it, strs);
+            }
+            break;
+        case YAML::NodeType::Map:
+            for (auto it : node) {
+                if (it.first.IsScalar()) {
+                    const auto& key = it.first.Scalar();
+                    if (strings_.try_emplace(key).second) {
+                        strs.push_back(key);
+                    }
+                }
+                collect_strings(it.second, strs);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+ElementBuilder::plain_scalar_t ElementBuilder::classify_plain_scalar(
+    const std::string& str
+) {
+    plain_scalar_t result;
+    if (parse_bool(str, result.bool_value)) {
+        result.type = Element::Type::BOOL;
+    } else if (parse_int64(str, result.int64_value)) {
+        result.type = Element::Type::INT64;
+    } else if (parse_double(str, result.double_value)) {
+        result.type = Element::Type::DOUBLE;
+    }
+    return result;
+}
+
+bool ElementBuilder::parse_bool(const std::string& str, bool& value) {
+    if (str == "true") {
+        value = true;
+        return true;
+    } else if (str == "false") {
+        value = false;
+        return true;
+    }
+    return false;
+}
+
+bool ElementBuilder::parse_int64(const std::string& str, int64_t& value) {
+    char *end;
+    errno = 0;
+    value = std::strtoll(str.c_str(), &end, 10);
+    return !errno && (str.c_str() != end) && (*end == 0);
+}
+
+bool ElementBuilder::parse_double(const std::string& str, double& value) {
+    char *end;
+    errno = 0;
+    value = std::strtod(str.c_str(), &end);
+    return !errno && (str.c_str() != end) && (*end == 0);
+}
+
+jmutils::string::String ElementBuilder::add_string(const std::string& str) {
+    if (auto search = strings_.find(str); search != strings_.end()) {
+        return search->second;
+    }
+    return pool_->add(str);
+}
+
 bool ElementBuilder::is_a_valid_path(
     const Element& element
 ) {
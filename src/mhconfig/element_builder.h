@@ -1,6 +1,11 @@
 #ifndef MHCONFIG__ELEMENT_BUILDER_H
 #define MHCONFIG__ELEMENT_BUILDER_H
 
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
 #include "jmutils/base64.h"
 #include "mhconfig/element.h"
 #include "mhconfig/string_pool.h"
@@ -21,6 +26,9 @@ public:
         absl::flat_hash_set<std::string>& reference_to
     );
 
+    // Intern all the strings of the node at once before build it
+    Element build(YAML::Node &node);
+
     Element make_and_check(YAML::Node &node);
 
 private:
@@ -28,6 +36,25 @@ private:
     jmutils::string::Pool* pool_;
     const std::string& document_;
     absl::flat_hash_set<std::string>& reference_to_;
+    absl::flat_hash_map<std::string, jmutils::string::String> strings_;
+
+    void intern_strings(YAML::Node &node);
+    void collect_strings(YAML::Node &node, std::vector<std::string>& strs);
+    jmutils::string::String add_string(const std::string& str);
+
+    // A plain scalar is a bool, a int64 or a double if it could be parsed
+    // as one of them in that order, otherwise it's a string
+    struct plain_scalar_t {
+        Element::Type type{Element::Type::STR};
+        bool bool_value{false};
+        int64_t int64_value{0};
+        double double_value{0.0};
+    };
+
+    static plain_scalar_t classify_plain_scalar(const std::string& str);
+    static bool parse_bool(const std::string& str, bool& value);
+    static bool parse_int64(const std::string& str, int64_t& value);
+    static bool parse_double(const std::string& str, double& value);
 
     inline Element make(YAML::Node &node);
     Element make_from_scalar(YAML::Node &node);
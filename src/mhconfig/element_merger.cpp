@@ -3,16 +3,56 @@
 namespace mhconfig
 {
 
-ElementMerger::ElementMerger(
+// Write a scalar like his conversion to std::string, it follows the
+// std::to_chars conventions
+static std::to_chars_result format_scalar(
+    const Element& element,
+    char* first,
+    char* last
+) {
+    switch (element.type()) {
+        case Element::Type::STR: // Fallback
+        case Element::Type::BIN:
+            return element.as<jmutils::string::String>().to_chars(first, last);
+        case Element::Type::INT64:
+            return std::to_chars(first, last, element.as<int64_t>());
+        case Element::Type::DOUBLE:
+            return std::to_chars(first, last, element.as<double>(), std::chars_format::fixed, 6);
+        case Element::Type::BOOL: {
+            std::string_view value(element.as<bool>() ? "true" : "false");
+            if ((size_t) (last - first) < value.size()) {
+                return {last, std::errc::value_too_large};
+            }
+            return {std::copy(value.begin(), value.end(), first), std::errc()};
+        }
+        default:
+            break;
+    }
+    return {first, std::errc::invalid_argument};
+}
+
+static size_t formatted_size(const Element& element) {
+    if (auto r = element.try_as<jmutils::string::String>(); r) {
+        return r->size();
+    }
+    // Enough for the fixed notation of any double
+    std::array<char, 512> buffer;
+    return format_scalar(element, buffer.data(), buffer.data() + buffer.size()).ptr - buffer.data();
+}
+
+template <ReplayLogger::Level MaxLevel>
+BasicElementMerger<MaxLevel>::BasicElementMerger(
     jmutils::string::Pool* pool,
     const absl::flat_hash_map<std::string, Element> &element_by_document_name
 ) : pool_(pool),
     element_by_document_name_(element_by_document_name),
-    empty_(true)
+    empty_(true),
+    use_references_(false)
 {
 }
 
-void ElementMerger::add(
+template <ReplayLogger::Level MaxLevel>
+void BasicElementMerger<MaxLevel>::add(
     const std::shared_ptr<PersistentLogger>& logger,
     const Element& element
 ) {
@@ -25,7 +65,8 @@ void ElementMerger::add(
     }
 }
 
-Element ElementMerger::finish() {
+template <ReplayLogger::Level MaxLevel>
+Element BasicElementMerger<MaxLevel>::finish() {
     if (empty_) return Element();
 
     // In this phase the merge and delete tags are handled
@@ -45,26 +86,90 @@ Element ElementMerger::finish() {
 
     root_.freeze();
     empty_ = true;
+    use_references_ = false;
+    ref_by_path_.clear();
+    sref_by_path_.clear();
     return root_;
 }
 
-MultiPersistentLogger& ElementMerger::logger() {
+template <ReplayLogger::Level MaxLevel>
+void BasicElementMerger<MaxLevel>::resume(
+    const Element& element,
+    MultiPersistentLogger& logger
+) {
+    logger_.inject_back(logger);
+    root_ = element;
+    empty_ = false;
+}
+
+template <ReplayLogger::Level MaxLevel>
+bool BasicElementMerger<MaxLevel>::snapshot(
+    Element& element,
+    MultiPersistentLogger& logger
+) {
+    if (empty_ || use_references_) return false;
+
+    root_.freeze();
+    element = root_;
+    logger.inject_back(logger_);
+    return true;
+}
+
+template <ReplayLogger::Level MaxLevel>
+bool BasicElementMerger<MaxLevel>::merge_values(
+    const Element& root,
+    const std::vector<const Element*>& values,
+    bool is_in_first_map,
+    Element& result
+) {
+    bool present = false;
+    for (size_t i = 0, l = values.size(); i < l; ++i) {
+        const Element& value = *values[i];
+        if ((i == 0) && is_in_first_map) {
+            result = value;
+            present = true;
+        } else if (!present) {
+            if (value.tag() != Element::Tag::DELETE) {
+                debug("Adding map key", root, value);
+                result = value;
+                present = true;
+            } else {
+                logger_.warn("Trying to remove a non-existent key", root, value);
+            }
+        } else {
+            debug("Merging map value", result, value);
+            auto r = override_with(result, value);
+            if (r.tag() == Element::Tag::DELETE) {
+                debug("Removed map key", result, value);
+                present = false;
+            } else {
+                result = std::move(r);
+            }
+        }
+    }
+
+    return present;
+}
+
+template <ReplayLogger::Level MaxLevel>
+MultiPersistentLogger& BasicElementMerger<MaxLevel>::logger() {
     return logger_;
 }
 
-Element ElementMerger::override_with(
+template <ReplayLogger::Level MaxLevel>
+Element BasicElementMerger<MaxLevel>::override_with(
     const Element& a,
     const Element& b
 ) {
     switch (b.tag()) {
         case Element::Tag::OVERRIDE:
-            logger_.debug("Overriding element", a, b);
+            debug("Overriding element", a, b);
             return b;
         case Element::Tag::DELETE:
-            logger_.debug("Deleting element", a, b);
+            debug("Deleting element", a, b);
             return b;
         case Element::Tag::MERGE:
-            logger_.debug("Applying merge in the second element", a, b);
+            debug("Applying merge in the second element", a, b);
             return apply_tag_merge(a, b);
         case Element::Tag::REF: {
             auto r = apply_tag_ref(b);
@@ -76,10 +181,10 @@ Element ElementMerger::override_with(
 
     switch (a.tag()) {
         case Element::Tag::DELETE:
-            logger_.debug("Overriding delete element", a, b);
+            debug("Overriding delete element", a, b);
             return b;
         case Element::Tag::MERGE: {
-            logger_.debug("Applying merge in the first element", a, b);
+            debug("Applying merge in the first element", a, b);
             auto initial = apply_tag_merge(a);
             return override_with(initial, b);
         }
@@ -96,7 +201,7 @@ Element ElementMerger::override_with(
             if (a.virtual_type() != Element::VirtualType::LITERAL) {
                 return without_override_error(a, b);
             }
-            logger_.debug("Overriding element", a, b);
+            debug("Overriding element", a, b);
             return b;
         }
 
@@ -105,25 +210,25 @@ Element ElementMerger::override_with(
                 return without_override_error(a, b);
             }
 
+            // The nodes are shared, so only the paths to the keys of the
+            // second map are copied
             Element result(a);
             auto map_a = result.as_map_mut();
-            auto map_b = b.as_map();
-            map_a->reserve(map_a->size() + map_b->size());
 
-            for (const auto& x : *map_b) {
-                const auto& search = map_a->find(x.first);
+            for (const auto& x : *b.as_map()) {
+                auto search = map_a->find(x.first);
                 if (search == map_a->end()) {
                     if (x.second.tag() != Element::Tag::DELETE) {
-                        logger_.debug("Adding map key", a, x.second);
-                        (*map_a)[x.first] = x.second;
+                        debug("Adding map key", a, x.second);
+                        map_a->emplace(x.first, x.second);
                     } else {
                         logger_.warn("Trying to remove a non-existent key", a, x.second);
                     }
                 } else {
-                    logger_.debug("Merging map value", search->second, x.second);
+                    debug("Merging map value", search->second, x.second);
                     auto r = override_with(search->second, x.second);
                     if (r.tag() == Element::Tag::DELETE) {
-                        logger_.debug("Removed map key", search->second, x.second);
+                        debug("Removed map key", search->second, x.second);
                         map_a->erase(search);
                     } else {
                         search->second = std::move(r);
@@ -139,15 +244,14 @@ Element ElementMerger::override_with(
                 return without_override_error(a, b);
             }
 
-            logger_.debug("Appending sequence", a, b);
+            debug("Appending sequence", a, b);
 
+            // Only the last path of the first sequence is copied
             Element result(a);
             auto seq_a = result.as_seq_mut();
-            auto seq_b = b.as_seq();
-            seq_a->reserve(seq_a->size() + seq_b->size());
 
-            for (size_t i = 0, l = seq_b->size(); i < l; ++i) {
-                seq_a->push_back((*seq_b)[i]);
+            for (const auto& x : *b.as_seq()) {
+                seq_a->push_back(x);
             }
 
             return result;
@@ -163,7 +267,8 @@ Element ElementMerger::override_with(
     return Element().set_origin(a);
 }
 
-std::pair<bool, Element> ElementMerger::apply_tags(
+template <ReplayLogger::Level MaxLevel>
+std::pair<bool, Element> BasicElementMerger<MaxLevel>::apply_tags(
     bool apply_references,
     Element element,
     const Element& root,
@@ -172,24 +277,43 @@ std::pair<bool, Element> ElementMerger::apply_tags(
     bool any_changed = false;
 
     if (element.tag() == Element::Tag::MERGE) {
-        logger_.debug("Applying merge element", element);
+        debug("Applying merge element", element);
         element = apply_tag_merge(element);
         any_changed = true;
     }
 
-    if (element.type() == Element::Type::MAP) {
+    // The frozen subtrees without tags to apply are the same
+    uint8_t tags = Element::tag_mask(Element::Tag::MERGE)
+        | Element::tag_mask(Element::Tag::DELETE);
+    if (apply_references) {
+        tags |= Element::tag_mask(Element::Tag::REF)
+            | Element::tag_mask(Element::Tag::SREF)
+            | Element::tag_mask(Element::Tag::FORMAT);
+    }
+
+    bool visit_children = element.may_contain_tags(tags);
+
+    // The frozen nodes of the containers without tags to apply are skipped
+    auto skip_node = [tags](const auto& metadata) {
+        return !(metadata.tags & tags);
+    };
+
+    if (visit_children && (element.type() == Element::Type::MAP)) {
         std::vector<jmutils::string::String> to_remove;
         std::vector<std::pair<jmutils::string::String, Element>> to_modify;
 
-        for (const auto& it : *element.as_map()) {
-            auto r = apply_tags(apply_references, it.second, root, depth+1);
-            if (r.second.tag() == Element::Tag::DELETE) {
-                logger_.warn("Removing an unused deletion node", r.second);
-                to_remove.push_back(it.first);
-            } else if (r.first) {
-                to_modify.emplace_back(it.first, std::move(r.second));
+        element.as_map()->for_each(
+            skip_node,
+            [&](const auto& it) {
+                auto r = apply_tags(apply_references, it.second, root, depth+1);
+                if (r.second.tag() == Element::Tag::DELETE) {
+                    logger_.warn("Removing an unused deletion node", r.second);
+                    to_remove.push_back(it.first);
+                } else if (r.first) {
+                    to_modify.emplace_back(it.first, std::move(r.second));
+                }
             }
-        }
+        );
 
         any_changed = !(to_remove.empty() && to_modify.empty());
         if (any_changed) {
@@ -201,28 +325,47 @@ std::pair<bool, Element> ElementMerger::apply_tags(
                 (*map)[to_modify[i].first] = std::move(to_modify[i].second);
             }
         }
-    } else if (element.type() == Element::Type::SEQUENCE) {
-        std::vector<Element> new_seq;
-        auto seq = element.as_seq();
-        new_seq.reserve(seq->size());
-
-        for (size_t i = 0, l = seq->size(); i < l; ++i) {
-            auto r = apply_tags(apply_references, (*seq)[i], root, depth+1);
-            if (r.second.tag() == Element::Tag::DELETE) {
-                logger_.warn(
-                    "A deletion node don't makes sense inside a sequence, removing it",
-                    (*seq)[i]
-                );
-                any_changed = true;
-            } else {
-                any_changed |= r.first;
-                new_seq.push_back(std::move(r.second));
+    } else if (visit_children && (element.type() == Element::Type::SEQUENCE)) {
+        std::vector<size_t> to_remove;
+        std::vector<std::pair<size_t, Element>> to_modify;
+
+        element.as_seq()->for_each(
+            skip_node,
+            [&](size_t idx, const Element& e) {
+                auto r = apply_tags(apply_references, e, root, depth+1);
+                if (r.second.tag() == Element::Tag::DELETE) {
+                    logger_.warn(
+                        "A deletion node don't makes sense inside a sequence, removing it",
+                        e
+                    );
+                    to_remove.push_back(idx);
+                } else if (r.first) {
+                    to_modify.emplace_back(idx, std::move(r.second));
+                }
             }
-        }
+        );
 
-        if (any_changed) {
-            auto seq_mut = element.as_seq_mut();
-            std::swap(*seq_mut, new_seq);
+        if (!(to_remove.empty() && to_modify.empty())) {
+            any_changed = true;
+            auto seq = element.as_seq_mut();
+            for (size_t i = 0, l = to_modify.size(); i < l; ++i) {
+                (*seq)[to_modify[i].first] = std::move(to_modify[i].second);
+            }
+
+            // The removed values move the rest, so the sequence is built again
+            if (!to_remove.empty()) {
+                std::sort(to_remove.begin(), to_remove.end());
+                Seq new_seq;
+                size_t j = 0;
+                for (size_t i = 0, l = seq->size(); i < l; ++i) {
+                    if ((j < to_remove.size()) && (to_remove[j] == i)) {
+                        ++j;
+                    } else {
+                        new_seq.push_back(std::as_const(*seq)[i]);
+                    }
+                }
+                *seq = std::move(new_seq);
+            }
         }
     }
 
@@ -235,7 +378,8 @@ std::pair<bool, Element> ElementMerger::apply_tags(
     return std::make_pair(any_changed, std::move(element));
 }
 
-std::pair<bool, Element> ElementMerger::post_apply_tags(
+template <ReplayLogger::Level MaxLevel>
+std::pair<bool, Element> BasicElementMerger<MaxLevel>::post_apply_tags(
     Element element,
     const Element& root,
     uint32_t depth
@@ -268,70 +412,122 @@ std::pair<bool, Element> ElementMerger::post_apply_tags(
     return std::make_pair(any_changed, std::move(element));
 }
 
-Element ElementMerger::apply_tag_format(
+template <ReplayLogger::Level MaxLevel>
+Element BasicElementMerger<MaxLevel>::apply_tag_format(
     const Element& element,
     const Element& root,
     uint32_t depth
 ) {
-    std::stringstream ss;
+    // The referenced slices are resolved before to render the string with
+    // his final size, the first value has the size of the literals of the
+    // template and the indexes of the references
     auto slices = element.as_seq();
-    for (size_t i = 0, l = slices->size(); i < l; ++i) {
-        auto v = post_apply_tags((*slices)[i], root, depth+1);
-        if (auto r = v.second.try_as<std::string>(); r) {
-            ss << *r;
-        } else {
+    auto hint = slices->front().as_seq();
+    std::vector<Element> values;
+    values.reserve(slices->size());
+    for (size_t i = 1, l = slices->size(); i < l; ++i) {
+        values.push_back((*slices)[i]);
+    }
+
+    size_t size = hint->front().as<int64_t>();
+    for (size_t i = 1, l = hint->size(); i < l; ++i) {
+        auto& value = values[(*hint)[i].as<int64_t>()-1];
+        std::pair<bool, Element> v = post_apply_tags(value, root, depth+1);
+        if (!v.second.is_scalar()) {
             logger_.error("The format tag references must be scalars", element);
             return Element().set_origin(element);
         }
+        size += formatted_size(v.second);
+        value = std::move(v.second);
     }
-    logger_.debug("Formated string", element);
-    return Element(pool_->add(ss.str())).set_origin(element);
+
+    auto result = pool_->add(size, [&values, size](char* output) {
+        char* last = output + size;
+        for (const auto& value : values) {
+            output = format_scalar(value, output, last).ptr;
+        }
+    });
+
+    debug("Formated string", element);
+    return Element(std::move(result)).set_origin(element);
 }
 
-Element ElementMerger::apply_tag_ref(
+template <ReplayLogger::Level MaxLevel>
+Element BasicElementMerger<MaxLevel>::apply_tag_ref(
     const Element& element
 ) {
+    use_references_ = true;
+
     const auto path = element.as_seq();
 
-    auto key_result = (*path)[0].try_as<std::string>();
-    if (!key_result) {
-        logger_.error("The first sequence value must be a string", element);
-        return Element().set_origin(element);
+    // The key is the document name followed by the path in it
+    std::vector<jmutils::string::String> key;
+    key.reserve(path->size());
+    for (size_t i = 0, l = path->size(); i < l; ++i) {
+        auto k = (*path)[i].try_as<jmutils::string::String>();
+        if (!k) {
+            logger_.error(
+                i == 0
+                    ? "The first sequence value must be a string"
+                    : "All the sequence values must be a strings",
+                element
+            );
+            return Element().set_origin(element);
+        }
+        key.push_back(std::move(*k));
     }
-    auto search = element_by_document_name_.find(*key_result);
-    if (search == element_by_document_name_.end()) {
-        logger_.error("Can't ref to the document", element);
-        return Element().set_origin(element);
+
+    if (auto memo = ref_by_path_.find(key); memo != ref_by_path_.end()) {
+        debug("Applied ref", element, memo->second);
+        return memo->second;
     }
 
-    auto referenced_element = search->second;
-    for (size_t i = 1, l = path->size(); i < l; ++i) {
-        auto k = (*path)[i].try_as<jmutils::string::String>();
-        if (!k) {
-            logger_.error("All the sequence values must be a strings", element);
+    Element referenced_element;
+    {
+        jmutils::string::PinnedString document(key.front());
+        auto search = element_by_document_name_.find(document.view());
+        if (search == element_by_document_name_.end()) {
+            logger_.error("Can't ref to the document", element);
             return Element().set_origin(element);
         }
-        referenced_element = referenced_element.get(*k);
+        referenced_element = search->second;
+    }
+
+    for (size_t i = 1, l = key.size(); i < l; ++i) {
+        referenced_element = referenced_element.get(key[i]);
     }
 
-    logger_.debug("Applied ref", element, referenced_element);
+    debug("Applied ref", element, referenced_element);
+    ref_by_path_.emplace(std::move(key), referenced_element);
     return referenced_element;
 }
 
-Element ElementMerger::apply_tag_sref(
+template <ReplayLogger::Level MaxLevel>
+Element BasicElementMerger<MaxLevel>::apply_tag_sref(
     const Element& element,
     const Element& root,
     uint32_t depth
 ) {
-    Element new_element = root;
     const auto path = element.as_seq();
+    std::vector<jmutils::string::String> key;
+    key.reserve(path->size());
     for (size_t i = 0, l = path->size(); i < l; ++i) {
         auto k = (*path)[i].try_as<jmutils::string::String>();
         if (!k) {
             logger_.error("All the sequence values must be a strings", element);
             return Element().set_origin(element);
         }
-        new_element = new_element.get(*k);
+        key.push_back(std::move(*k));
+    }
+
+    if (auto memo = sref_by_path_.find(key); memo != sref_by_path_.end()) {
+        debug("Applied sref", element, memo->second);
+        return memo->second;
+    }
+
+    Element new_element = root;
+    for (size_t i = 0, l = key.size(); i < l; ++i) {
+        new_element = new_element.get(key[i]);
     }
 
     new_element = post_apply_tags(new_element, root, depth+1).second;
@@ -341,32 +537,38 @@ Element ElementMerger::apply_tag_sref(
         return Element().set_origin(element);
     }
 
-    logger_.debug("Applied sref", element, new_element);
+    debug("Applied sref", element, new_element);
+    sref_by_path_.emplace(std::move(key), new_element);
     return new_element;
 }
 
-Element ElementMerger::apply_tag_merge(
+template <ReplayLogger::Level MaxLevel>
+Element BasicElementMerger<MaxLevel>::apply_tag_merge(
     Element initial,
     const Element& merge_element
 ) {
     auto seq = merge_element.as_seq();
     for (size_t i = 0, l = seq->size(); i < l; ++i) {
-        logger_.debug("Doing merge", initial, (*seq)[i]);
+        debug("Doing merge", initial, (*seq)[i]);
         initial = override_with(initial, (*seq)[i]);
     }
     return initial;
 }
 
-Element ElementMerger::apply_tag_merge(
+template <ReplayLogger::Level MaxLevel>
+Element BasicElementMerger<MaxLevel>::apply_tag_merge(
     const Element& merge_element
 ) {
     auto seq = merge_element.as_seq();
     Element initial = (*seq)[0];
     for (size_t i = 1, l = seq->size(); i < l; ++i) {
-        logger_.debug("Doing merge", initial, (*seq)[i]);
+        debug("Doing merge", initial, (*seq)[i]);
         initial = override_with(initial, (*seq)[i]);
     }
     return initial;
 }
 
+template class BasicElementMerger<ReplayLogger::Level::warn>;
+template class BasicElementMerger<ReplayLogger::Level::trace>;
+
 } /* mhconfig */
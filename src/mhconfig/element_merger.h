@@ -1,6 +1,16 @@
 #ifndef MHCONFIG__ELEMENT_MERGER_H
 #define MHCONFIG__ELEMENT_MERGER_H
 
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+
 #include "mhconfig/element.h"
 #include "mhconfig/string_pool.h"
 #include "mhconfig/logger/logger.h"
@@ -15,10 +25,13 @@ using logger::ReplayLogger;
 using logger::PersistentLogger;
 using logger::MultiPersistentLogger;
 
-class ElementMerger final
+// The logs with a level greater than the max level aren't recorded,
+// so the build could avoid them when nobody is going to ask for them
+template <ReplayLogger::Level MaxLevel>
+class BasicElementMerger final
 {
 public:
-    ElementMerger(
+    BasicElementMerger(
         jmutils::string::Pool* pool,
         const absl::flat_hash_map<std::string, Element> &element_by_document_name
     );
@@ -30,8 +43,38 @@ public:
 
     Element finish();
 
+    // Continue a merge from a not finished result of other merger
+    void resume(
+        const Element& element,
+        MultiPersistentLogger& logger
+    );
+
+    // Obtain the not finished result, only if it doesn't
+    // depend of the referenced documents
+    bool snapshot(
+        Element& element,
+        MultiPersistentLogger& logger
+    );
+
+    // Merge the values of a key of the root maps like the override of
+    // the maps do it, returning false if the key is removed
+    bool merge_values(
+        const Element& root,
+        const std::vector<const Element*>& values,
+        bool is_in_first_map,
+        Element& result
+    );
+
+    inline bool use_references() const {
+        return use_references_;
+    }
+
     MultiPersistentLogger& logger();
 
+    inline static constexpr ReplayLogger::Level max_level() {
+        return MaxLevel;
+    }
+
 private:
     MultiPersistentLogger logger_;
     jmutils::string::Pool* pool_;
@@ -39,6 +82,18 @@ private:
 
     Element root_;
     bool empty_;
+    bool use_references_;
+
+    // The resolved references of the merge, the root only changes
+    // between the phases of the finish and no sref is applied before
+    absl::flat_hash_map<
+        std::vector<jmutils::string::String>,
+        Element
+    > ref_by_path_;
+    absl::flat_hash_map<
+        std::vector<jmutils::string::String>,
+        Element
+    > sref_by_path_;
 
     Element override_with(
         const Element& a,
@@ -91,8 +146,18 @@ private:
         return Element().set_origin(a);
     }
 
+    template <typename... Args>
+    inline void debug(Args&&... args) {
+        if constexpr (MaxLevel >= ReplayLogger::Level::debug) {
+            logger_.debug(std::forward<Args>(args)...);
+        }
+    }
+
 };
 
+typedef BasicElementMerger<ReplayLogger::Level::trace> ElementMerger;
+typedef BasicElementMerger<ReplayLogger::Level::warn> WarnElementMerger;
+
 } /* mhconfig */
 
 #endif
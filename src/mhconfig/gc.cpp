@@ -109,6 +109,26 @@ void gc_cn_dead_pointers(
   cn->mutex.ReaderUnlock();
 }
 
+bool gc_cn_string_pool(
+  config_namespace_t* cn,
+  const jmutils::MonotonicTimePoint& deadline
+) {
+  std::shared_ptr<jmutils::string::Pool> pool;
+
+  cn->mutex.ReaderLock();
+  if ((cn->status == ConfigNamespaceStatus::OK) || (cn->status == ConfigNamespaceStatus::OK_UPDATING)) {
+    pool = cn->pool;
+  }
+  cn->mutex.ReaderUnlock();
+
+  if (pool == nullptr) {
+    return true;
+  }
+
+  spdlog::debug("Compacting the string pool of the namespace '{}'", cn->root_path);
+  return pool->compact(deadline);
+}
+
 void gc_cn_raw_config_versions(
   config_namespace_t* cn,
   uint64_t timelimit_s
@@ -239,6 +259,22 @@ bool gc_document_raw_config_versions(
     need_clean = document->oldest_version < oldest_version;
     if (need_clean) {
       document->oldest_version = oldest_version;
+      // The overrides previous to the ones of the oldest version can't be asked
+      auto overrides_version = get_overrides_version_locked(document, oldest_version);
+      document->overrides_versions.erase(
+        document->overrides_versions.begin(),
+        document->overrides_versions.lower_bound(overrides_version)
+      );
+      for (
+        auto it = document->overrides_key_by_labels.begin();
+        it != document->overrides_key_by_labels.end();
+      ) {
+        if (it->first.first < overrides_version) {
+          document->overrides_key_by_labels.erase(it++);
+        } else {
+          ++it;
+        }
+      }
     }
     document->mutex.Unlock();
   }
@@ -295,6 +331,9 @@ bool gc_document_raw_config_versions(
             override_->raw_config_by_version.begin(),
             it2
           );
+          // The merges could use the removed raw configs
+          document->merge_prefix_by_key.clear();
+          document->merged_key_by_sources.clear();
         }
         if (override_->raw_config_by_version.empty()) {
           spdlog::trace(
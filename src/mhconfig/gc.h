@@ -7,6 +7,7 @@
 
 #include "jmutils/common.h"
 #include "jmutils/container/label_set.h"
+#include "jmutils/time.h"
 #include "mhconfig/builder.h"
 #include "mhconfig/config_namespace.h"
 #include "mhconfig/context.h"
@@ -30,6 +31,11 @@ void gc_cn_raw_config_versions(
   uint64_t timelimit_s
 );
 
+bool gc_cn_string_pool(
+  config_namespace_t* cn,
+  const jmutils::MonotonicTimePoint& deadline
+);
+
 bool need_clean_cn_raw_config_versions(
   config_namespace_t* cn,
   uint64_t timelimit_s,
@@ -103,6 +103,41 @@ public:
         return loggers_.empty() && ((last_logger_ == nullptr) || last_logger_->empty());
     }
 
+    std::shared_ptr<ReplayLogger> clone_changing_document(
+        uint16_t document_id,
+        uint16_t new_document_id,
+        const absl::flat_hash_map<uint16_t, uint16_t>& new_raw_config_id_by_id
+    ) const override {
+        auto logger = std::make_shared<MultiPersistentLogger>();
+        logger->inject_back_changing_document(
+            *this,
+            document_id,
+            new_document_id,
+            new_raw_config_id_by_id
+        );
+        return logger;
+    }
+
+    // Inject a copy of the frozen logs of other logger without modify it,
+    // since it could be replayed at the same time
+    void inject_back_changing_document(
+        const MultiPersistentLogger& logger,
+        uint16_t document_id,
+        uint16_t new_document_id,
+        const absl::flat_hash_map<uint16_t, uint16_t>& new_raw_config_id_by_id
+    ) {
+        for (auto& x : logger.loggers_) {
+            push_back_frozen(
+                x->clone_changing_document(
+                    document_id,
+                    new_document_id,
+                    new_raw_config_id_by_id
+                )
+            );
+        }
+        assert((logger.last_logger_ == nullptr) || logger.last_logger_->empty());
+    }
+
 private:
     jmutils::container::LinkedList<std::shared_ptr<ReplayLogger>> loggers_;
     std::shared_ptr<ReplayLogger> last_logger_{nullptr};
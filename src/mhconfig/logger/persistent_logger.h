@@ -97,17 +97,17 @@
             LOGGER.LEVEL(LOG->str.static_, POSITION, ORIGIN); \
             break; \
         case CallType::DINAMIC_STR: { \
-            auto s = LOG->str.dinamic.str(); \
+            MessageCStr s(LOG->str.dinamic); \
             LOGGER.LEVEL(s.c_str()); \
             break; \
         } \
         case CallType::DINAMIC_STR_POSITION: { \
-            auto s = LOG->str.dinamic.str(); \
+            MessageCStr s(LOG->str.dinamic); \
             LOGGER.LEVEL(s.c_str(), POSITION); \
             break; \
         } \
         case CallType::DINAMIC_STR_POSITION_ORIGIN: { \
-            auto s = LOG->str.dinamic.str(); \
+            MessageCStr s(LOG->str.dinamic); \
             LOGGER.LEVEL(s.c_str(), POSITION, ORIGIN); \
             break; \
         } \
@@ -118,6 +118,39 @@ namespace mhconfig
 namespace logger
 {
 
+// A null terminated copy of a dynamic message to replay it, the short ones
+// are copied in the stack to avoid allocate them in every replay
+class MessageCStr final
+{
+public:
+    explicit MessageCStr(const jmutils::string::String& message) {
+        size_t size = message.size();
+        if (size < sizeof(buffer_)) {
+            message.copy(buffer_);
+            buffer_[size] = '\0';
+            data_ = buffer_;
+        } else {
+            str_ = message.str();
+            data_ = str_.c_str();
+        }
+    }
+
+    MessageCStr(const MessageCStr& o) = delete;
+    MessageCStr(MessageCStr&& o) = delete;
+
+    MessageCStr& operator=(const MessageCStr& o) = delete;
+    MessageCStr& operator=(MessageCStr&& o) = delete;
+
+    inline const char* c_str() const {
+        return data_;
+    }
+
+private:
+    const char* data_;
+    std::string str_;
+    char buffer_[256];
+};
+
 class PersistentLogger final : public ReplayLogger
 {
 public:
@@ -237,6 +270,34 @@ public:
         return heads_[LOGGER_NUM_LEVELS-1].value() == 7;
     }
 
+    std::shared_ptr<ReplayLogger> clone_changing_document(
+        uint16_t document_id,
+        uint16_t new_document_id,
+        const absl::flat_hash_map<uint16_t, uint16_t>& new_raw_config_id_by_id
+    ) const override {
+        auto logger = std::make_shared<PersistentLogger>();
+        for (size_t i = 0; i < LOGGER_NUM_LEVELS; ++i) {
+            logger->heads_[i].value(heads_[i].value());
+            LogChunkPtr* last = &logger->heads_[i];
+            for (log_chunk_t* ptr = heads_[i].ptr(); ptr != nullptr; ptr = ptr->next.ptr()) {
+                log_chunk_t* chunk = jmutils::new_aligned_ptr<3, log_chunk_t, size_t>(0).ptr();
+                last->ptr(chunk);
+                for (size_t j = 0, l = ptr->next.value(); j < l; ++j) {
+                    copy_log(ptr->logs[j], chunk->logs[j]);
+                    change_document(
+                        chunk->logs[j],
+                        document_id,
+                        new_document_id,
+                        new_raw_config_id_by_id
+                    );
+                    chunk->next.incr();
+                }
+                last = &chunk->next;
+            }
+        }
+        return logger;
+    }
+
 private:
     enum class CallType : uint8_t {
         STATIC_STR = 0,
@@ -317,6 +378,54 @@ private:
         return log;
     }
 
+    void copy_log(const log_t& log, log_t& result) const {
+        switch (log.call_type) {
+            case CallType::STATIC_STR:
+            case CallType::STATIC_STR_POSITION:
+            case CallType::STATIC_STR_POSITION_ORIGIN:
+                result.str.static_ = log.str.static_;
+                break;
+            case CallType::DINAMIC_STR:
+            case CallType::DINAMIC_STR_POSITION:
+            case CallType::DINAMIC_STR_POSITION_ORIGIN:
+                new (&result.str.dinamic) jmutils::string::String(log.str.dinamic);
+                break;
+        }
+        result.call_type = log.call_type;
+        result.start = log.start;
+        result.next = log.next;
+        result.position_document_id = log.position_document_id;
+        result.position_raw_config_id = log.position_raw_config_id;
+        result.position_line = log.position_line;
+        result.position_col = log.position_col;
+        result.origin_col = log.origin_col;
+        result.origin_line = log.origin_line;
+        result.origin_raw_config_id = log.origin_raw_config_id;
+        result.origin_document_id = log.origin_document_id;
+    }
+
+    void change_document(
+        log_t& log,
+        uint16_t document_id,
+        uint16_t new_document_id,
+        const absl::flat_hash_map<uint16_t, uint16_t>& new_raw_config_id_by_id
+    ) const {
+        if (log.position_document_id == document_id) {
+            auto search = new_raw_config_id_by_id.find(log.position_raw_config_id);
+            if (search != new_raw_config_id_by_id.end()) {
+                log.position_document_id = new_document_id;
+                log.position_raw_config_id = search->second;
+            }
+        }
+        if (log.origin_document_id == document_id) {
+            auto search = new_raw_config_id_by_id.find(log.origin_raw_config_id);
+            if (search != new_raw_config_id_by_id.end()) {
+                log.origin_document_id = new_document_id;
+                log.origin_raw_config_id = search->second;
+            }
+        }
+    }
+
     void delete_log_chunk(LogChunkPtr head) {
         while (true) {
             log_chunk_t* ptr = head.ptr();
@@ -1,6 +1,9 @@
 #ifndef MHCONFIG__LOGGER__REPLAY_LOGGER_H
 #define MHCONFIG__LOGGER__REPLAY_LOGGER_H
 
+#include <absl/container/flat_hash_map.h>
+#include <memory>
+
 #include "mhconfig/logger/logger.h"
 
 #define LOGGER_NUM_LEVELS_BITS 2
@@ -56,6 +59,14 @@ public:
   ) const = 0;
 
   virtual bool empty() const = 0;
+
+  // Copy the frozen logs moving the positions in the raw configs of a
+  // document to the raw configs of other document with the same content
+  virtual std::shared_ptr<ReplayLogger> clone_changing_document(
+    uint16_t document_id,
+    uint16_t new_document_id,
+    const absl::flat_hash_map<uint16_t, uint16_t>& new_raw_config_id_by_id
+  ) const = 0;
 };
 
 } /* logger */
@@ -18,12 +18,12 @@ void Metrics::init(const std::string& address) {
     .Help("How many nanoseconds takes process a task by a worker thread")
     .Register(*registry_);
 
-  family_optimized_merged_config_used_bytes_summary_ = &prometheus::BuildSummary()
+
+  family_optimized_merged_config_used_bytes_gauge_ = &prometheus::BuildGauge()
     .Name("optimized_merged_config_used_bytes")
-    .Help("The number of used bytes in the optimized merged config")
+    .Help("The number of used bytes by the encoded responses of the optimized merged configs")
     .Register(*registry_);
 
-
   family_string_pool_num_strings_gauge_ = &prometheus::BuildGauge()
     .Name("string_pool_num_strings")
     .Help("The number of strings in the pool")
@@ -62,8 +62,8 @@ void Metrics::add(
         .Observe(value);
       return;
     case Id::OPTIMIZED_MERGED_CONFIG_USED_BYTES:
-      family_optimized_merged_config_used_bytes_summary_->Add(labels, quantiles_)
-        .Observe(value);
+      family_optimized_merged_config_used_bytes_gauge_->Add(labels)
+        .Increment(value);
       return;
     case Id::STRING_POOL_NUM_STRINGS:
       family_string_pool_num_strings_gauge_->Add(labels)
@@ -21,9 +21,9 @@ public:
     // Observable
     API_DURATION_NANOSECONDS,
     WORKER_DURATION_NANOSECONDS,
-    OPTIMIZED_MERGED_CONFIG_USED_BYTES,
 
     // Gauges
+    OPTIMIZED_MERGED_CONFIG_USED_BYTES,
     STRING_POOL_NUM_STRINGS,
     STRING_POOL_NUM_CHUNKS,
     STRING_POOL_RECLAIMED_BYTES,
@@ -55,8 +55,8 @@ private:
 
   prometheus::Family<prometheus::Summary>* family_api_duration_summary_{nullptr};
   prometheus::Family<prometheus::Summary>* family_worker_duration_summary_{nullptr};
-  prometheus::Family<prometheus::Summary>* family_optimized_merged_config_used_bytes_summary_{nullptr};
 
+  prometheus::Family<prometheus::Gauge>* family_optimized_merged_config_used_bytes_gauge_{nullptr};
   prometheus::Family<prometheus::Gauge>* family_string_pool_num_strings_gauge_{nullptr};
   prometheus::Family<prometheus::Gauge>* family_string_pool_num_chunks_gauge_{nullptr};
   prometheus::Family<prometheus::Gauge>* family_string_pool_reclaimed_bytes_gauge_{nullptr};
@@ -137,6 +137,17 @@ bool MHConfig::run_time_worker() {
     }
   );
 
+  time_worker_.set_function(
+    static_cast<uint32_t>(TimeWorkerTag::RUN_GC_STRING_POOLS),
+    current_time_ms + 30000,
+    [ctx=ctx_.get()]() -> uint64_t {
+      ctx->worker_queue.push(
+        std::make_unique<worker::GCStringPoolsCommand>(10)
+      );
+      return jmutils::monotonic_now_ms() + 30000;
+    }
+  );
+
   return time_worker_.start();
 }
 
@@ -16,6 +16,7 @@
 #include "mhconfig/worker/gc_dead_pointers_command.h"
 #include "mhconfig/worker/gc_merged_configs_command.h"
 #include "mhconfig/worker/gc_raw_config_versions_command.h"
+#include "mhconfig/worker/gc_string_pools_command.h"
 #include "spdlog/spdlog.h"
 
 namespace mhconfig
@@ -52,6 +53,7 @@ private:
     RUN_GC_DEAD_POINTERS,
     RUN_GC_NAMESPACES,
     RUN_GC_VERSIONS,
+    RUN_GC_STRING_POOLS,
   };
 
   std::string config_path_;
@@ -49,6 +49,61 @@ void ApiGetConfigTask::on_complete(
   request_->commit();
 }
 
+bool ApiGetConfigTask::on_complete_encoded(
+  std::shared_ptr<config_namespace_t>& cn,
+  VersionId version,
+  merged_config_t* merged_config
+) {
+  auto elements = obtain_encoded_elements(
+    merged_config,
+    request_->response_type(),
+    request_->with_position()
+  );
+  if (elements == nullptr) {
+    return false;
+  }
+
+  auto logs = obtain_encoded_logs(
+    cn.get(),
+    merged_config,
+    request_->response_type(),
+    request_->with_position(),
+    log_level(),
+    *elements
+  );
+  if (logs == nullptr) {
+    return false;
+  }
+
+  if (cn != nullptr) {
+    request_->set_namespace_id(cn->id);
+  }
+  request_->set_version(version);
+  request_->set_checksum(
+    merged_config->checksum.data(),
+    merged_config->checksum.size()
+  );
+
+  // The logs of the task are in the message, so only the sources that
+  // aren't already encoded are added to it
+  api::SourceIds source_ids;
+  for (const auto& id : sources_logger_.sources()) {
+    if (!logs->source_ids.contains(id)) {
+      source_ids.insert(id);
+    }
+  }
+  request_->set_encoded_elements(std::move(elements));
+  request_->set_encoded_logs(std::move(logs));
+
+  if (!source_ids.empty()) {
+    auto sources = make_sources(source_ids, cn.get());
+    request_->set_sources(sources);
+  }
+
+  request_->commit();
+  return true;
+}
+
 Logger& ApiGetConfigTask::logger() {
   return logger_;
 }
@@ -190,6 +245,72 @@ ReplayLogger::Level AuthTokenGetConfigTask::log_level() const {
   return ReplayLogger::Level::error;
 }
 
+PrewarmGetConfigTask::PrewarmGetConfigTask(
+  VersionId version,
+  Labels&& labels,
+  std::string&& root_path,
+  std::string&& document,
+  std::shared_ptr<prewarm_counter_t>& counter
+) : version_(version),
+  labels_(std::move(labels)),
+  root_path_(std::move(root_path)),
+  document_(std::move(document)),
+  counter_(counter)
+{
+  counter_->mutex.Lock();
+  counter_->num_pending += 1;
+  counter_->mutex.Unlock();
+}
+
+PrewarmGetConfigTask::~PrewarmGetConfigTask() {
+  counter_->mutex.Lock();
+  counter_->num_pending -= 1;
+  counter_->mutex.Unlock();
+}
+
+const std::string& PrewarmGetConfigTask::root_path() const {
+  return root_path_;
+}
+
+uint32_t PrewarmGetConfigTask::version() const {
+  return version_;
+}
+
+const Labels& PrewarmGetConfigTask::labels() const {
+  return labels_;
+}
+
+const std::string& PrewarmGetConfigTask::document() const {
+  return document_;
+}
+
+void PrewarmGetConfigTask::on_complete(
+  std::shared_ptr<config_namespace_t>& cn,
+  VersionId version,
+  const Element& element,
+  const std::array<uint8_t, 32>& checksum,
+  void* payload
+) {
+  spdlog::debug(
+    "Prewarmed the document '{}' with labels {} in the version {}",
+    document_,
+    labels_,
+    version
+  );
+}
+
+Logger& PrewarmGetConfigTask::logger() {
+  return logger_;
+}
+
+ReplayLogger::Level PrewarmGetConfigTask::log_level() const {
+  return ReplayLogger::Level::error;
+}
+
+bool PrewarmGetConfigTask::is_traceable() const {
+  return false;
+}
+
 void send_existing_watcher_traces(
   config_namespace_t* cn,
   document_versions_t* dv,
@@ -222,6 +343,113 @@ void send_existing_watcher_traces(
   );
 }
 
+// The first encoded value is the kept one, the bytes of it are added to the
+// used ones by the merged config
+template <typename T>
+static void store_encoded_locked(
+  merged_config_t* merged_config,
+  std::shared_ptr<const T>& stored,
+  std::shared_ptr<const T>& encoded
+) {
+  if (stored != nullptr) {
+    encoded = stored;
+    return;
+  }
+
+  stored = encoded;
+  if (merged_config->metrics != nullptr) {
+    merged_config->encoded_bytes += encoded->data.size();
+    merged_config->metrics->add(
+      Metrics::Id::OPTIMIZED_MERGED_CONFIG_USED_BYTES,
+      {},
+      encoded->data.size()
+    );
+  }
+}
+
+std::shared_ptr<const api::encoded_elements_t> obtain_encoded_elements(
+  merged_config_t* merged_config,
+  api::ResponseType response_type,
+  bool with_position
+) {
+  size_t idx = encoded_elements_idx(response_type, with_position);
+
+  merged_config->mutex.ReaderLock();
+  bool is_optimized = merged_config->status == MergedConfigStatus::OPTIMIZED;
+  auto encoded = merged_config->encoded_elements[idx];
+  merged_config->mutex.ReaderUnlock();
+
+  if (is_optimized && (encoded == nullptr)) {
+    // The value of a optimized merged config isn't modified, so if more
+    // than one request encode it at the same time the first one is kept
+    encoded = api::encode_elements(
+      merged_config->value,
+      api::elements_field_number(response_type),
+      with_position
+    );
+
+    merged_config->mutex.Lock();
+    store_encoded_locked(
+      merged_config,
+      merged_config->encoded_elements[idx],
+      encoded
+    );
+    merged_config->mutex.Unlock();
+  }
+
+  return encoded;
+}
+
+std::shared_ptr<const api::encoded_logs_t> obtain_encoded_logs(
+  config_namespace_t* cn,
+  merged_config_t* merged_config,
+  api::ResponseType response_type,
+  bool with_position,
+  ReplayLogger::Level log_level,
+  const api::encoded_elements_t& elements
+) {
+  if (static_cast<size_t>(log_level) >= NUM_ENCODED_LOG_LEVELS) {
+    return nullptr;
+  }
+
+  size_t idx = encoded_logs_idx(response_type, with_position, log_level);
+
+  merged_config->mutex.ReaderLock();
+  bool is_optimized = merged_config->status == MergedConfigStatus::OPTIMIZED;
+  auto encoded = merged_config->encoded_logs[idx];
+  merged_config->mutex.ReaderUnlock();
+
+  if (is_optimized && (encoded == nullptr)) {
+    api::LogsEncoder encoder(response_type);
+    logger::SourcesLogger sources_logger;
+    logger::ApiLogger<api::LogsEncoder*> api_logger(&encoder);
+    logger::BiLogger<Logger*> logger{&sources_logger, &api_logger};
+    merged_config->logger.replay(logger, log_level);
+
+    auto logs = std::make_shared<api::encoded_logs_t>();
+    logs->source_ids = std::move(sources_logger.sources());
+    logs->source_ids.insert(
+      elements.source_ids.cbegin(),
+      elements.source_ids.cend()
+    );
+    if (!logs->source_ids.empty()) {
+      encoder.set_sources(make_sources(logs->source_ids, cn));
+    }
+    logs->data = encoder.encode();
+    encoded = std::move(logs);
+
+    merged_config->mutex.Lock();
+    store_encoded_locked(
+      merged_config,
+      merged_config->encoded_logs[idx],
+      encoded
+    );
+    merged_config->mutex.Unlock();
+  }
+
+  return encoded;
+}
+
 bool process_get_config_task(
   std::shared_ptr<config_namespace_t>&& cn,
   std::shared_ptr<GetConfigTask>&& task,
@@ -303,6 +531,46 @@ bool process_get_config_task(
     return false;
   }
 
+  return process_get_config_task(
+    std::move(cn),
+    std::move(task),
+    version,
+    std::move(cfg_document),
+    std::move(document),
+    ctx
+  );
+}
+
+bool process_prewarm_config_task(
+  std::shared_ptr<config_namespace_t>&& cn,
+  std::shared_ptr<GetConfigTask>&& task,
+  context_t* ctx
+) {
+  VersionId version = task->version();
+
+  cn->mutex.ReaderLock();
+  auto cfg_document = get_document_locked(cn.get(), "mhconfig", version);
+  auto document = get_document_locked(cn.get(), task->document(), version);
+  cn->mutex.ReaderUnlock();
+
+  return process_get_config_task(
+    std::move(cn),
+    std::move(task),
+    version,
+    std::move(cfg_document),
+    std::move(document),
+    ctx
+  );
+}
+
+bool process_get_config_task(
+  std::shared_ptr<config_namespace_t>&& cn,
+  std::shared_ptr<GetConfigTask>&& task,
+  VersionId version,
+  std::shared_ptr<document_t>&& cfg_document,
+  std::shared_ptr<document_t>&& document,
+  context_t* ctx
+) {
   if (!is_a_valid_document(version, cfg_document.get(), document.get(), task.get())) {
     finish_with_error(task.get(), cn, version);
     return false;
@@ -312,14 +580,13 @@ bool process_get_config_task(
 
   std::string overrides_key;
 
-  bool is_a_valid_version = for_each_document_override(
+  bool is_a_valid_version = get_overrides_key(
     cfg,
+    cfg_document.get(),
     document.get(),
     task->labels(),
     version,
-    [&overrides_key](auto&& raw_config) {
-      jmutils::push_uint16(overrides_key, raw_config->id);
-    }
+    overrides_key
   );
   if (!is_a_valid_version) {
     task->logger().error("The asked version don't exists");
@@ -327,20 +594,22 @@ bool process_get_config_task(
     return true;
   }
 
-  for_each_trace_to_trigger(
-    cn.get(),
-    task.get(),
-    [version, cn=cn.get(), task=task.get()](auto* trace) {
-      auto om = make_trace_output_message(
-        trace,
-        api::stream::TraceOutputMessage::Status::RETURNED_ELEMENTS,
-        cn->id,
-        version,
-        task
-      );
-      om->commit();
-    }
-  );
+  if (task->is_traceable()) {
+    for_each_trace_to_trigger(
+      cn.get(),
+      task.get(),
+      [version, cn=cn.get(), task=task.get()](auto* trace) {
+        auto om = make_trace_output_message(
+          trace,
+          api::stream::TraceOutputMessage::Status::RETURNED_ELEMENTS,
+          cn->id,
+          version,
+          task
+        );
+        om->commit();
+      }
+    );
+  }
 
   spdlog::debug(
     "Searching the merged config of a overrides_key with size {}",
@@ -388,28 +657,17 @@ bool process_get_config_task(
     case CheckMergedConfigResult::IN_PROGRESS:
       spdlog::debug("The operation is in progress");
       return true;
-    case CheckMergedConfigResult::BUILD_CONFIG: {
+    case CheckMergedConfigResult::BUILD_CONFIG:
       spdlog::debug("The operation need build the config");
-
-      auto pending_build = std::make_shared<pending_build_t>();
-      pending_build->version = version;
-      pending_build->task = std::move(task);
-      build_element_t be{
-        .document = std::move(document),
-        .merged_config = std::move(merged_config)
-      };
-      pending_build->elements.push_back(std::move(be));
-
-      execute_command_in_worker_thread(
-        std::make_unique<worker::BuildCommand>(
-          std::move(cn),
-          std::move(pending_build)
-        ),
+      build_merged_config(
+        std::move(cn),
+        std::move(task),
+        version,
+        std::move(document),
+        std::move(merged_config),
         ctx
       );
-
       return true;
-    }
     case CheckMergedConfigResult::OPTIMIZE_CONFIG: {
       spdlog::debug("Optimizing and commiting the message");
 
@@ -436,6 +694,33 @@ bool process_get_config_task(
   return false;
 }
 
+void build_merged_config(
+  std::shared_ptr<config_namespace_t>&& cn,
+  std::shared_ptr<GetConfigTask>&& task,
+  VersionId version,
+  std::shared_ptr<document_t>&& document,
+  std::shared_ptr<merged_config_t>&& merged_config,
+  context_t* ctx
+) {
+  auto pending_build = std::make_shared<pending_build_t>();
+  pending_build->version = version;
+  pending_build->log_level = task->log_level();
+  pending_build->task = std::move(task);
+  build_element_t be{
+    .document = std::move(document),
+    .merged_config = std::move(merged_config)
+  };
+  pending_build->elements.push_back(std::move(be));
+
+  execute_command_in_worker_thread(
+    std::make_unique<worker::BuildCommand>(
+      std::move(cn),
+      std::move(pending_build)
+    ),
+    ctx
+  );
+}
+
 bool is_a_valid_document(
   VersionId version,
   document_t* cfg_document,
@@ -57,6 +57,12 @@ public:
     void* payload
   ) override;
 
+  bool on_complete_encoded(
+    std::shared_ptr<config_namespace_t>& cn,
+    VersionId version,
+    merged_config_t* merged_config
+  ) override;
+
   Logger& logger() override;
 
   ReplayLogger::Level log_level() const override;
@@ -74,6 +80,10 @@ inline void finish_successfully(
   VersionId version,
   merged_config_t* merged_config
 ) {
+  if (task->on_complete_encoded(cn, version, merged_config)) {
+    return;
+  }
+
   // It's neccesary a lock for this?
   merged_config->logger.replay(task->logger(), task->log_level());
 
@@ -100,12 +110,76 @@ inline void finish_with_error(
   );
 }
 
+inline size_t encoded_elements_idx(
+  api::ResponseType response_type,
+  bool with_position
+) {
+  return static_cast<size_t>(response_type)*2 + (with_position ? 1 : 0);
+}
+
+inline size_t encoded_logs_idx(
+  api::ResponseType response_type,
+  bool with_position,
+  ReplayLogger::Level log_level
+) {
+  return encoded_elements_idx(response_type, with_position)*NUM_ENCODED_LOG_LEVELS
+    + static_cast<size_t>(log_level);
+}
+
+// Obtain the elements of a optimized merged config encoded for a response,
+// they are encoded the first time that they are asked
+std::shared_ptr<const api::encoded_elements_t> obtain_encoded_elements(
+  merged_config_t* merged_config,
+  api::ResponseType response_type,
+  bool with_position
+);
+
+// Obtain the logs of a optimized merged config encoded for a response with
+// the sources of them and the elements, like the elements they are encoded
+// the first time that they are asked
+std::shared_ptr<const api::encoded_logs_t> obtain_encoded_logs(
+  config_namespace_t* cn,
+  merged_config_t* merged_config,
+  api::ResponseType response_type,
+  bool with_position,
+  ReplayLogger::Level log_level,
+  const api::encoded_elements_t& elements
+);
+
 bool process_get_config_task(
   std::shared_ptr<config_namespace_t>&& cn,
   std::shared_ptr<GetConfigTask>&& task,
   context_t* ctx
 );
 
+bool process_get_config_task(
+  std::shared_ptr<config_namespace_t>&& cn,
+  std::shared_ptr<GetConfigTask>&& task,
+  VersionId version,
+  std::shared_ptr<document_t>&& cfg_document,
+  std::shared_ptr<document_t>&& document,
+  context_t* ctx
+);
+
+// Like process_get_config_task but allowing the next version of the config
+// namespace, that it's only available to the update that is preparing it
+bool process_prewarm_config_task(
+  std::shared_ptr<config_namespace_t>&& cn,
+  std::shared_ptr<GetConfigTask>&& task,
+  context_t* ctx
+);
+
+// Build the merged config of a task, if it's already built without
+// the logs asked by the task it's built again without cache it
+void build_merged_config(
+  std::shared_ptr<config_namespace_t>&& cn,
+  std::shared_ptr<GetConfigTask>&& task,
+  VersionId version,
+  std::shared_ptr<document_t>&& document,
+  std::shared_ptr<merged_config_t>&& merged_config,
+  context_t* ctx
+);
+
 bool is_a_valid_document(
   VersionId version,
   document_t* cfg_document,
@@ -212,6 +286,56 @@ private:
   std::shared_ptr<context_t> ctx_;
 };
 
+// The number of prewarm tasks not released yet, the update waits for it
+// to reach zero
+struct prewarm_counter_t {
+  absl::Mutex mutex;
+  uint32_t num_pending{0};
+};
+
+// Build the merged config of some labels without anybody waiting for it,
+// the pending counter is decreased once the task is released
+class PrewarmGetConfigTask final : public GetConfigTask
+{
+public:
+  PrewarmGetConfigTask(
+    VersionId version,
+    Labels&& labels,
+    std::string&& root_path,
+    std::string&& document,
+    std::shared_ptr<prewarm_counter_t>& counter
+  );
+  ~PrewarmGetConfigTask();
+
+  const std::string& root_path() const override;
+  uint32_t version() const override;
+  const Labels& labels() const override;
+  const std::string& document() const override;
+
+  void on_complete(
+    std::shared_ptr<config_namespace_t>& cn,
+    VersionId version,
+    const Element& element,
+    const std::array<uint8_t, 32>& checksum,
+    void* payload
+  ) override;
+
+  Logger& logger() override;
+
+  ReplayLogger::Level log_level() const override;
+
+  bool is_traceable() const override;
+
+private:
+  logger::CounterLogger logger_;
+
+  VersionId version_;
+  Labels labels_;
+  std::string root_path_;
+  std::string document_;
+  std::shared_ptr<prewarm_counter_t> counter_;
+};
+
 } /* mhconfig */
 
 #endif
@@ -1,6 +1,9 @@
 #ifndef MHCONFIG__STRING_POOL_H
 #define MHCONFIG__STRING_POOL_H
 
+#include <atomic>
+#include <string>
+
 #include "jmutils/string/pool.h"
 #include "mhconfig/metrics.h"
 
@@ -17,34 +20,47 @@ public:
     const std::string& id
   ) : metrics_(metrics),
     id_(id),
-    sequential_id_(0)
+    sequential_id_(0),
+    num_strings_(0),
+    num_chunks_(0),
+    reclaimed_bytes_(0),
+    used_bytes_(0)
   {
   }
 
-  void on_updated_stats(const jmutils::string::stats_t& stats, bool force) override {
+  void on_updated_stats(const jmutils::string::stats_delta_t& delta, bool force) override {
+    auto num_strings = num_strings_.fetch_add(delta.num_strings, std::memory_order_relaxed)
+      + delta.num_strings;
+    auto num_chunks = num_chunks_.fetch_add(delta.num_chunks, std::memory_order_relaxed)
+      + delta.num_chunks;
+    auto reclaimed_bytes = reclaimed_bytes_.fetch_add(delta.reclaimed_bytes, std::memory_order_relaxed)
+      + delta.reclaimed_bytes;
+    auto used_bytes = used_bytes_.fetch_add(delta.used_bytes, std::memory_order_relaxed)
+      + delta.used_bytes;
+
     if (force || (sequential_id_++ == 0)) {
       metrics_.add(
         Metrics::Id::STRING_POOL_NUM_STRINGS,
         {{"pool", id_}},
-        stats.num_strings
+        num_strings
       );
 
       metrics_.add(
         Metrics::Id::STRING_POOL_NUM_CHUNKS,
         {{"pool", id_}},
-        stats.num_chunks
+        num_chunks
       );
 
       metrics_.add(
         Metrics::Id::STRING_POOL_RECLAIMED_BYTES,
         {{"pool", id_}},
-        stats.reclaimed_bytes
+        reclaimed_bytes
       );
 
       metrics_.add(
         Metrics::Id::STRING_POOL_USED_BYTES,
         {{"pool", id_}},
-        stats.used_bytes
+        used_bytes
       );
     }
   }
@@ -52,7 +68,12 @@ public:
 private:
   Metrics& metrics_;
   std::string id_;
-  uint8_t sequential_id_;
+  std::atomic<uint8_t> sequential_id_;
+  // The totals of the pool, accumulated from the changes of its shards
+  std::atomic<int64_t> num_strings_;
+  std::atomic<int64_t> num_chunks_;
+  std::atomic<int64_t> reclaimed_bytes_;
+  std::atomic<int64_t> used_bytes_;
 };
 
 } /* string_pool */
@@ -26,7 +26,7 @@ bool BuildCommand::execute(
     context_t* ctx
 ) {
     prepare_pending_build();
-    decrease_pending_elements(ctx, pending_build_.get());
+    decrease_pending_elements(ctx, cn_, pending_build_);
     return true;
 }
 
@@ -94,52 +94,93 @@ void BuildCommand::prepare_pending_build_rec(
         build_element.document.get(),
         overrides_key
     );
+    build_element.overrides_key = std::move(overrides_key);
     auto merged_config = build_element.merged_config.get();
     merged_config->last_access_timestamp = jmutils::monotonic_now_sec();
 
-    merged_config->mutex.ReaderLock();
-    switch (merged_config->status) {
-        case MergedConfigStatus::UNDEFINED: // Fallback
-        case MergedConfigStatus::BUILDING:
-            break;
-        case MergedConfigStatus::NO_OPTIMIZED: // Fallback
-        case MergedConfigStatus::OPTIMIZING: // Fallback
-        case MergedConfigStatus::OPTIMIZED: // Fallback
-        case MergedConfigStatus::OPTIMIZATION_FAIL:
-            build_element.config = merged_config->value;
-            merged_config->mutex.ReaderUnlock();
-            return;
-    }
-    merged_config->mutex.ReaderUnlock();
+    // The shared merged configs only have the error and warning logs, so
+    // all the referenced documents are built again to obtain the rest
+    bool detach = !dfs_doc_names.empty()
+        && (pending_build_->log_level > ReplayLogger::Level::warn);
 
-    merged_config->mutex.Lock();
-    switch (merged_config->status) {
-        case MergedConfigStatus::UNDEFINED:
-            merged_config->status = MergedConfigStatus::BUILDING;
-            merged_config->reference_to = reference_to;
-            build_element.to_build = true;
-            break;
-        case MergedConfigStatus::BUILDING:
-            pending_build_->num_pending.fetch_add(1, std::memory_order_relaxed);
-            merged_config->to_build.push_back(pending_build_);
-            // The root merged config has the building status but
-            // in reality is like a undefined one
-            if (dfs_doc_names.empty()) {
+    if (!detach) {
+        merged_config->mutex.ReaderLock();
+        switch (merged_config->status) {
+            case MergedConfigStatus::UNDEFINED: // Fallback
+            case MergedConfigStatus::BUILDING:
+                break;
+            case MergedConfigStatus::NO_OPTIMIZED: // Fallback
+            case MergedConfigStatus::OPTIMIZING: // Fallback
+            case MergedConfigStatus::OPTIMIZED: // Fallback
+            case MergedConfigStatus::OPTIMIZATION_FAIL:
+                if (merged_config->log_level >= pending_build_->log_level) {
+                    build_element.config = merged_config->value;
+                    merged_config->mutex.ReaderUnlock();
+                    return;
+                }
+                break;
+        }
+        merged_config->mutex.ReaderUnlock();
+
+        merged_config->mutex.Lock();
+        switch (merged_config->status) {
+            case MergedConfigStatus::UNDEFINED:
+                merged_config->status = MergedConfigStatus::BUILDING;
                 merged_config->reference_to = reference_to;
                 build_element.to_build = true;
                 break;
-            }
-            merged_config->mutex.Unlock();
-            return;
-        case MergedConfigStatus::NO_OPTIMIZED: // Fallback
-        case MergedConfigStatus::OPTIMIZING: // Fallback
-        case MergedConfigStatus::OPTIMIZED: // Fallback
-        case MergedConfigStatus::OPTIMIZATION_FAIL:
-            build_element.config = merged_config->value;
-            merged_config->mutex.Unlock();
-            return;
+            case MergedConfigStatus::BUILDING:
+                pending_build_->num_pending.fetch_add(1, std::memory_order_relaxed);
+                merged_config->to_build.push_back(pending_build_);
+                // The root merged config has the building status but
+                // in reality is like a undefined one
+                if (dfs_doc_names.empty()) {
+                    merged_config->reference_to = reference_to;
+                    build_element.to_build = true;
+                    break;
+                }
+                merged_config->mutex.Unlock();
+                return;
+            case MergedConfigStatus::NO_OPTIMIZED: // Fallback
+            case MergedConfigStatus::OPTIMIZING: // Fallback
+            case MergedConfigStatus::OPTIMIZED: // Fallback
+            case MergedConfigStatus::OPTIMIZATION_FAIL:
+                if (merged_config->log_level >= pending_build_->log_level) {
+                    build_element.config = merged_config->value;
+                    merged_config->mutex.Unlock();
+                    return;
+                }
+                detach = true;
+                break;
+        }
+        merged_config->mutex.Unlock();
+
+        // The root merged config is shared, so it's built like the others
+        // and the tasks that ask for more logs are dispatched again later
+        if (!detach) {
+            pending_build_->log_level = std::min(
+                pending_build_->log_level,
+                ReplayLogger::Level::warn
+            );
+        }
+    }
+
+    // The merged config hasn't the asked logs, so it's built again
+    // with them in a merged config that isn't shared
+    if (detach) {
+        spdlog::debug(
+            "Building the document '{}' again to obtain the logs",
+            build_element.document->name
+        );
+        build_element.merged_config = std::make_shared<merged_config_t>();
+        build_element.merged_config->status = MergedConfigStatus::BUILDING;
+        build_element.merged_config->reference_to = reference_to;
+        if (dfs_doc_names.empty()) {
+            build_element.merged_config->waiting.push_back(pending_build_->task);
+        }
+        build_element.to_build = true;
+        build_element.detached = true;
     }
-    merged_config->mutex.Unlock();
 
     dfs_doc_names_set.insert(build_element.document->name);
     dfs_doc_names.push_back(build_element.document->name);
@@ -165,102 +206,6 @@ void BuildCommand::prepare_pending_build_rec(
     dfs_doc_names.pop_back();
 }
 
-void BuildCommand::decrease_pending_elements(
-    context_t* ctx,
-    pending_build_t* pending_build
-) {
-    if (pending_build->num_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-        build(ctx, pending_build);
-    }
-}
-
-void BuildCommand::build(
-    context_t* ctx,
-    pending_build_t* pending_build
-) {
-    absl::flat_hash_map<std::string, Element> element_by_document_name;
-    absl::flat_hash_map<std::string, merged_config_t*> merged_config_by_document_name;
-
-    for (auto& be: pending_build->elements) {
-        if (be.to_build) {
-            spdlog::debug(
-                "Building the document '{}' with id {}",
-                be.document->name,
-                be.document->id
-            );
-
-            ElementMerger merger(
-                cn_->pool.get(),
-                element_by_document_name
-            );
-
-            absl::flat_hash_set<std::string> mc_reference_to;
-            for (const auto& name: be.merged_config->reference_to) {
-                auto search = merged_config_by_document_name.find(name);
-                if (search != merged_config_by_document_name.end()) {
-                    merger.logger().inject_back(search->second->logger);
-
-                    auto& reference_to = search->second->reference_to;
-                    mc_reference_to.insert(
-                        reference_to.cbegin(),
-                        reference_to.cend()
-                    );
-                }
-            }
-
-            for (const auto& it : be.raw_configs_to_merge) {
-                merger.add(it->logger, it->value);
-            }
-
-            Element config = merger.finish();
-
-            std::vector<std::shared_ptr<pending_build_t>> to_build;
-            std::vector<std::shared_ptr<GetConfigTask>> waiting;
-
-            be.merged_config->mutex.Lock();
-
-            be.merged_config->value = config;
-            be.merged_config->reference_to.merge(mc_reference_to);
-
-            if (!be.merged_config->waiting.empty()) {
-                be.merged_config->checksum = config.make_checksum();
-                if (alloc_payload_locked(be.merged_config.get())) {
-                    be.merged_config->status = MergedConfigStatus::OPTIMIZED;
-                } else {
-                    merger.logger().error("Some error take place allocating the payload");
-                    be.merged_config->status = MergedConfigStatus::OPTIMIZATION_FAIL;
-                }
-            } else {
-                be.merged_config->status = MergedConfigStatus::NO_OPTIMIZED;
-            }
-
-            std::swap(be.merged_config->to_build, to_build);
-            std::swap(be.merged_config->waiting, waiting);
-
-            be.merged_config->logger.inject_back(merger.logger());
-            be.merged_config->logger.freeze();
-
-            be.merged_config->mutex.Unlock();
-
-            for (size_t i = 0, l = waiting.size(); i < l; ++i) {
-                finish_successfully(
-                    waiting[i].get(),
-                    cn_,
-                    pending_build_->version,
-                    be.merged_config.get()
-                );
-            }
-
-            for (size_t i = 0, l = to_build.size(); i < l; ++i) {
-                decrease_pending_elements(ctx, to_build[i].get());
-            }
-        }
-
-        merged_config_by_document_name[be.document->name] = be.merged_config.get();
-        element_by_document_name[be.document->name] = be.merged_config->value;
-    }
-}
-
 void BuildCommand::log_cycle(
     build_element_t& cycle_end_be,
     const std::string& cycle_start_doc_name,
@@ -2,6 +2,7 @@
 #define MHCONFIG__WORKER__BUILD_COMMAND_H
 
 #include <absl/container/flat_hash_map.h>
+#include <algorithm>
 #include <memory>
 #include <optional>
 #include <string>
@@ -12,6 +13,7 @@
 #include "mhconfig/context.h"
 #include "mhconfig/provider.h"
 #include "mhconfig/element_merger.h"
+#include "mhconfig/worker/build_element_command.h"
 
 namespace mhconfig
 {
@@ -57,16 +59,6 @@ private:
         const Element& cfg
     );
 
-    void decrease_pending_elements(
-        context_t* ctx,
-        pending_build_t* pending_build
-    );
-
-    void build(
-        context_t* ctx,
-        pending_build_t* pending_build
-    );
-
     void log_cycle(
         build_element_t& cycle_end_be,
         const std::string& cycle_start_doc_name,
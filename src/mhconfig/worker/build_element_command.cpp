@@ -0,0 +1,539 @@
+#include "mhconfig/worker/build_element_command.h"
+
+namespace mhconfig
+{
+namespace worker
+{
+
+void decrease_pending_elements(
+    context_t* ctx,
+    const std::shared_ptr<config_namespace_t>& cn,
+    const std::shared_ptr<pending_build_t>& pending_build
+) {
+    if (pending_build->num_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        schedule_build(ctx, cn, pending_build);
+    }
+}
+
+void schedule_build(
+    context_t* ctx,
+    const std::shared_ptr<config_namespace_t>& cn,
+    const std::shared_ptr<pending_build_t>& pending_build
+) {
+    auto dag = std::make_shared<build_dag_t>();
+    dag->cn = cn;
+    dag->pending_build = pending_build;
+
+    absl::flat_hash_map<std::string, size_t> idx_by_document_name;
+    for (auto& be: pending_build->elements) {
+        if (be.to_build) {
+            idx_by_document_name[be.document->name] = dag->elements.size();
+            dag->elements.push_back(&be);
+        } else {
+            dag->merged_config_by_document_name[be.document->name] = be.merged_config.get();
+            dag->element_by_document_name[be.document->name] = be.merged_config->value;
+        }
+    }
+
+    // The elements are sorted by the DFS in post order, so only the
+    // references to the previous elements are used (a cycle is broken
+    // in the same place that a sequential build would do it)
+    size_t num_elements = dag->elements.size();
+    dag->dependents.resize(num_elements);
+    dag->num_dependencies.reset(new std::atomic<uint32_t>[num_elements]);
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < num_elements; ++i) {
+        uint32_t num_dependencies = 0;
+        for (const auto& name: dag->elements[i]->merged_config->reference_to) {
+            auto search = idx_by_document_name.find(name);
+            if ((search != idx_by_document_name.end()) && (search->second < i)) {
+                dag->dependents[search->second].push_back(i);
+                ++num_dependencies;
+            }
+        }
+        dag->num_dependencies[i].store(num_dependencies, std::memory_order_relaxed);
+        if (num_dependencies == 0) {
+            ready.push_back(i);
+        }
+    }
+
+    if (ready.empty()) return;
+
+    for (size_t i = 1, l = ready.size(); i < l; ++i) {
+        ctx->worker_queue.push(
+            std::make_unique<BuildElementCommand>(dag, ready[i])
+        );
+    }
+
+    BuildElementCommand command(std::move(dag), ready.front());
+    command.execute(ctx);
+}
+
+BuildElementCommand::BuildElementCommand(
+    std::shared_ptr<build_dag_t> dag,
+    size_t idx
+)
+    : dag_(std::move(dag)),
+    idx_(idx)
+{
+}
+
+std::string BuildElementCommand::name() const {
+    return "BUILD_ELEMENT";
+}
+
+bool BuildElementCommand::force_take_metric() const {
+    return true;
+}
+
+bool BuildElementCommand::execute(
+    context_t* ctx
+) {
+    while (true) {
+        build(ctx, *dag_->elements[idx_]);
+
+        // Continue with one of the ready elements in this thread
+        std::optional<size_t> next_idx;
+        for (size_t dependent: dag_->dependents[idx_]) {
+            if (dag_->num_dependencies[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (next_idx) {
+                    ctx->worker_queue.push(
+                        std::make_unique<BuildElementCommand>(dag_, *next_idx)
+                    );
+                }
+                next_idx = dependent;
+            }
+        }
+
+        if (!next_idx) break;
+        idx_ = *next_idx;
+    }
+
+    return true;
+}
+
+void BuildElementCommand::build(
+    context_t* ctx,
+    build_element_t& be
+) {
+    spdlog::debug(
+        "Building the document '{}' with id {}",
+        be.document->name,
+        be.document->id
+    );
+
+    // Only the referenced documents are needed to merge this one
+    absl::flat_hash_map<std::string, Element> element_by_document_name;
+    absl::flat_hash_map<std::string, merged_config_t*> merged_config_by_document_name;
+    dag_->mutex.ReaderLock();
+    for (const auto& name: be.merged_config->reference_to) {
+        auto search = dag_->merged_config_by_document_name.find(name);
+        if (search != dag_->merged_config_by_document_name.end()) {
+            merged_config_by_document_name[name] = search->second;
+            element_by_document_name[name] = dag_->element_by_document_name[name];
+        }
+    }
+    dag_->mutex.ReaderUnlock();
+
+    MultiPersistentLogger logger;
+    absl::flat_hash_set<std::string> mc_reference_to;
+    for (const auto& it: merged_config_by_document_name) {
+        logger.inject_back(it.second->logger);
+
+        auto& reference_to = it.second->reference_to;
+        mc_reference_to.insert(
+            reference_to.cbegin(),
+            reference_to.cend()
+        );
+    }
+
+    // The cached merged configs only keep the error and warning logs,
+    // the rest are obtained building again the config when they are asked
+    auto log_level = be.detached
+        ? std::max(dag_->pending_build->log_level, ReplayLogger::Level::warn)
+        : ReplayLogger::Level::warn;
+
+    Element config;
+    if (!adopt_migrated_merged_config(be, log_level, logger, config)) {
+        if (log_level >= ReplayLogger::Level::debug) {
+            config = merge<ElementMerger>(be, element_by_document_name, logger);
+        } else {
+            config = merge<WarnElementMerger>(be, element_by_document_name, logger);
+        }
+    }
+
+    std::vector<std::shared_ptr<pending_build_t>> to_build;
+    std::vector<std::shared_ptr<GetConfigTask>> waiting;
+
+    be.merged_config->mutex.Lock();
+
+    be.merged_config->value = config;
+    be.merged_config->log_level = log_level;
+    be.merged_config->reference_to.merge(mc_reference_to);
+
+    if (!be.merged_config->waiting.empty()) {
+        be.merged_config->checksum = config.make_checksum();
+        if (alloc_payload_locked(be.merged_config.get())) {
+            be.merged_config->status = MergedConfigStatus::OPTIMIZED;
+            be.merged_config->metrics = &ctx->metrics;
+        } else {
+            logger.error("Some error take place allocating the payload");
+            be.merged_config->status = MergedConfigStatus::OPTIMIZATION_FAIL;
+        }
+    } else {
+        be.merged_config->status = MergedConfigStatus::NO_OPTIMIZED;
+    }
+
+    std::swap(be.merged_config->to_build, to_build);
+    std::swap(be.merged_config->waiting, waiting);
+
+    be.merged_config->logger.inject_back(logger);
+    be.merged_config->logger.freeze();
+
+    be.merged_config->mutex.Unlock();
+
+    dag_->mutex.Lock();
+    dag_->merged_config_by_document_name[be.document->name] = be.merged_config.get();
+    dag_->element_by_document_name[be.document->name] = config;
+    dag_->mutex.Unlock();
+
+    for (size_t i = 0, l = waiting.size(); i < l; ++i) {
+        if (waiting[i]->log_level() > log_level) {
+            build_merged_config(
+                std::shared_ptr<config_namespace_t>(dag_->cn),
+                std::move(waiting[i]),
+                dag_->pending_build->version,
+                std::shared_ptr<document_t>(be.document),
+                std::shared_ptr<merged_config_t>(be.merged_config),
+                ctx
+            );
+        } else {
+            finish_successfully(
+                waiting[i].get(),
+                dag_->cn,
+                dag_->pending_build->version,
+                be.merged_config.get()
+            );
+        }
+    }
+
+    for (size_t i = 0, l = to_build.size(); i < l; ++i) {
+        decrease_pending_elements(ctx, dag_->cn, to_build[i]);
+    }
+}
+
+template <typename M>
+Element BuildElementCommand::merge(
+    build_element_t& be,
+    const absl::flat_hash_map<std::string, Element>& element_by_document_name,
+    MultiPersistentLogger& logger
+) {
+    M merger(
+        dag_->cn->pool.get(),
+        element_by_document_name
+    );
+    merge_raw_configs(merger, be, element_by_document_name);
+    Element config = merger.finish();
+    logger.inject_back(merger.logger());
+    return config;
+}
+
+bool BuildElementCommand::adopt_migrated_merged_config(
+    build_element_t& be,
+    ReplayLogger::Level log_level,
+    MultiPersistentLogger& logger,
+    Element& config
+) {
+    auto document = be.document.get();
+
+    document->mutex.ReaderLock();
+    auto migrated_from = document->migrated_from.lock();
+    std::string migrated_key;
+    absl::flat_hash_map<uint16_t, uint16_t> new_raw_config_id_by_id;
+    bool ok = migrated_from != nullptr;
+    for (size_t i = 0, l = be.overrides_key.size(); ok && (i+1 < l); i += sizeof(RawConfigId)) {
+        RawConfigId id = static_cast<uint8_t>(be.overrides_key[i])
+            | (static_cast<uint8_t>(be.overrides_key[i+1]) << 8);
+        auto search = document->migrated_raw_config_ids.find(id);
+        if (search == document->migrated_raw_config_ids.end()) {
+            ok = false;
+        } else {
+            jmutils::push_uint16(migrated_key, search->second);
+            new_raw_config_id_by_id[search->second] = id;
+        }
+    }
+    document->mutex.ReaderUnlock();
+
+    if (!ok) return false;
+
+    // The merged config of the previous document is valid if it has the
+    // same raw configs, the references changes would use new raw configs
+    auto migrated_merged_config = get_merged_config(migrated_from.get(), migrated_key);
+    if (migrated_merged_config == nullptr) return false;
+
+    migrated_merged_config->mutex.ReaderLock();
+    switch (migrated_merged_config->status) {
+        case MergedConfigStatus::UNDEFINED: // Fallback
+        case MergedConfigStatus::BUILDING:
+            ok = false;
+            break;
+        case MergedConfigStatus::NO_OPTIMIZED: // Fallback
+        case MergedConfigStatus::OPTIMIZING: // Fallback
+        case MergedConfigStatus::OPTIMIZED: // Fallback
+        case MergedConfigStatus::OPTIMIZATION_FAIL:
+            ok = migrated_merged_config->log_level >= log_level;
+            if (ok) {
+                config = migrated_merged_config->value;
+            }
+            break;
+    }
+    migrated_merged_config->mutex.ReaderUnlock();
+
+    if (!ok) return false;
+
+    spdlog::debug(
+        "Adopting the merged config of the migrated document '{}' with id {}",
+        document->name,
+        migrated_from->id
+    );
+
+    // The logs of the previous document are copied since they could be
+    // replayed by the requests of the previous versions
+    logger.inject_back_changing_document(
+        migrated_merged_config->logger,
+        migrated_from->id,
+        document->id,
+        new_raw_config_id_by_id
+    );
+
+    config.walk_mut(
+        [document_id=document->id, migrated_document_id=migrated_from->id, &new_raw_config_id_by_id](auto* e) {
+            if (e->document_id() == migrated_document_id) {
+                auto search = new_raw_config_id_by_id.find(e->raw_config_id());
+                if (search != new_raw_config_id_by_id.end()) {
+                    e->set_document_id(document_id);
+                    e->set_raw_config_id(search->second);
+                }
+            }
+        }
+    );
+    config.freeze();
+
+    return true;
+}
+
+template <typename M>
+void BuildElementCommand::merge_raw_configs(
+    M& merger,
+    build_element_t& be,
+    const absl::flat_hash_map<std::string, Element>& element_by_document_name
+) {
+    std::vector<raw_config_t*> raw_configs;
+    bool only_maps = true;
+    for (const auto& it : be.raw_configs_to_merge) {
+        raw_configs.push_back(it.get());
+        only_maps &= it->value.is_map() && (it->value.tag() == Element::Tag::NONE);
+    }
+
+    // The reused merges only have the logs of a build without the debug ones
+    if constexpr (M::max_level() >= ReplayLogger::Level::debug) {
+        for (auto raw_config : raw_configs) {
+            merger.add(raw_config->logger, raw_config->value);
+        }
+    } else if (only_maps && (raw_configs.size() > 1)) {
+        merge_raw_configs_by_key(
+            merger,
+            be.document.get(),
+            raw_configs,
+            element_by_document_name
+        );
+    } else {
+        merge_raw_configs_by_prefix(
+            merger,
+            be.document.get(),
+            raw_configs
+        );
+    }
+}
+
+void BuildElementCommand::merge_raw_configs_by_key(
+    WarnElementMerger& merger,
+    document_t* document,
+    const std::vector<raw_config_t*>& raw_configs,
+    const absl::flat_hash_map<std::string, Element>& element_by_document_name
+) {
+    // The values of every root key in the raw configs that have it
+    absl::flat_hash_map<Literal, size_t> idx_by_key;
+    std::vector<Literal> keys;
+    std::vector<std::vector<std::pair<size_t, const Element*>>> values_by_idx;
+    for (size_t i = 0, l = raw_configs.size(); i < l; ++i) {
+        for (const auto& it : *raw_configs[i]->value.as_map()) {
+            auto inserted = idx_by_key.emplace(it.first, keys.size());
+            if (inserted.second) {
+                keys.push_back(it.first);
+                values_by_idx.emplace_back();
+            }
+            values_by_idx[inserted.first->second].emplace_back(i, &it.second);
+        }
+    }
+
+    // A key only need to be merged again if some of his sources change,
+    // the first raw config is also a source since the merge of the values
+    // depends of it (e.g. to check the removed keys or log his position)
+    RawConfigId first_raw_config_id = raw_configs.front()->id;
+    std::vector<std::string> sources_keys(keys.size());
+    for (size_t i = 0, l = keys.size(); i < l; ++i) {
+        jmutils::string::PinnedString key(keys[i]);
+        jmutils::push_str(sources_keys[i], key.view());
+        jmutils::push_uint16(sources_keys[i], first_raw_config_id);
+        for (const auto& it : values_by_idx[i]) {
+            jmutils::push_uint16(sources_keys[i], raw_configs[it.first]->id);
+        }
+    }
+
+    std::vector<std::shared_ptr<merged_key_t>> merged_keys(keys.size());
+    document->mutex.ReaderLock();
+    for (size_t i = 0, l = keys.size(); i < l; ++i) {
+        auto search = document->merged_key_by_sources.find(sources_keys[i]);
+        if (search != document->merged_key_by_sources.end()) {
+            merged_keys[i] = search->second;
+        }
+    }
+    document->mutex.ReaderUnlock();
+
+    size_t num_merged_keys = 0;
+    std::vector<size_t> new_idxs;
+    std::vector<const Element*> values;
+    for (size_t i = 0, l = keys.size(); i < l; ++i) {
+        if (merged_keys[i] != nullptr) continue;
+        ++num_merged_keys;
+
+        values.clear();
+        for (const auto& it : values_by_idx[i]) {
+            values.push_back(it.second);
+        }
+
+        WarnElementMerger key_merger(
+            dag_->cn->pool.get(),
+            element_by_document_name
+        );
+        auto merged_key = std::make_shared<merged_key_t>();
+        merged_key->removed = !key_merger.merge_values(
+            raw_configs.front()->value,
+            values,
+            values_by_idx[i].front().first == 0,
+            merged_key->value
+        );
+        merged_key->value.freeze();
+        merged_key->logger.inject_back(key_merger.logger());
+        merged_keys[i] = std::move(merged_key);
+
+        // The referenced documents depends of the labels of the request
+        if (!key_merger.use_references()) {
+            new_idxs.push_back(i);
+        }
+    }
+
+    spdlog::trace(
+        "Merged {} of {} keys of the document '{}'",
+        num_merged_keys,
+        keys.size(),
+        document->name
+    );
+
+    if (!new_idxs.empty()) {
+        document->mutex.Lock();
+        if (document->merged_key_by_sources.size() + new_idxs.size() > MAX_MERGED_KEYS_BY_DOCUMENT) {
+            document->merged_key_by_sources.clear();
+        }
+        for (size_t i : new_idxs) {
+            document->merged_key_by_sources.emplace(
+                std::move(sources_keys[i]),
+                merged_keys[i]
+            );
+        }
+        document->mutex.Unlock();
+    }
+
+    Map map;
+    MultiPersistentLogger logger;
+    for (auto raw_config : raw_configs) {
+        logger.push_back_frozen(raw_config->logger);
+    }
+    for (size_t i = 0, l = keys.size(); i < l; ++i) {
+        if (!merged_keys[i]->removed) {
+            map[keys[i]] = merged_keys[i]->value;
+        }
+        logger.inject_back(merged_keys[i]->logger);
+    }
+
+    Element root(std::move(map));
+    root.set_origin(raw_configs.front()->value);
+    merger.resume(root, logger);
+}
+
+void BuildElementCommand::merge_raw_configs_by_prefix(
+    WarnElementMerger& merger,
+    document_t* document,
+    const std::vector<raw_config_t*>& raw_configs
+) {
+    std::string key;
+    for (auto raw_config : raw_configs) {
+        jmutils::push_uint16(key, raw_config->id);
+    }
+
+    size_t start = 0;
+    std::shared_ptr<merge_prefix_t> prefix;
+
+    document->mutex.ReaderLock();
+    for (size_t i = raw_configs.size(); (i > 1) && (prefix == nullptr); --i) {
+        auto search = document->merge_prefix_by_key.find(
+            absl::string_view(key.data(), i*sizeof(RawConfigId))
+        );
+        if (search != document->merge_prefix_by_key.end()) {
+            prefix = search->second;
+            start = i;
+        }
+    }
+    document->mutex.ReaderUnlock();
+
+    if (prefix != nullptr) {
+        spdlog::trace(
+            "Reusing the merge of {} of {} raw configs of the document '{}'",
+            start,
+            raw_configs.size(),
+            document->name
+        );
+        merger.resume(prefix->value, prefix->logger);
+    }
+
+    std::vector<std::pair<size_t, std::shared_ptr<merge_prefix_t>>> new_prefixes;
+    bool reusable = true;
+    for (size_t i = start, l = raw_configs.size(); i < l; ++i) {
+        merger.add(raw_configs[i]->logger, raw_configs[i]->value);
+        if (reusable && (i > 0)) {
+            auto new_prefix = std::make_shared<merge_prefix_t>();
+            reusable = merger.snapshot(new_prefix->value, new_prefix->logger);
+            if (reusable) {
+                new_prefixes.emplace_back(i+1, std::move(new_prefix));
+            }
+        }
+    }
+
+    if (!new_prefixes.empty()) {
+        document->mutex.Lock();
+        if (document->merge_prefix_by_key.size() + new_prefixes.size() > MAX_MERGE_PREFIXES_BY_DOCUMENT) {
+            document->merge_prefix_by_key.clear();
+        }
+        for (auto& it : new_prefixes) {
+            document->merge_prefix_by_key.emplace(
+                key.substr(0, it.first*sizeof(RawConfigId)),
+                std::move(it.second)
+            );
+        }
+        document->mutex.Unlock();
+    }
+}
+
+} /* worker */
+} /* mhconfig */
@@ -0,0 +1,114 @@
+#ifndef MHCONFIG__WORKER__BUILD_ELEMENT_COMMAND_H
+#define MHCONFIG__WORKER__BUILD_ELEMENT_COMMAND_H
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/string_view.h>
+#include <absl/synchronization/mutex.h>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "mhconfig/builder.h"
+#include "mhconfig/config_namespace.h"
+#include "mhconfig/context.h"
+#include "mhconfig/provider.h"
+#include "mhconfig/element_merger.h"
+
+namespace mhconfig
+{
+namespace worker
+{
+
+// The elements to build of a pending build, every one of them is merged
+// in a worker as soon as the previous elements that it reference are merged
+struct build_dag_t {
+    std::shared_ptr<config_namespace_t> cn;
+    std::shared_ptr<pending_build_t> pending_build;
+    std::vector<build_element_t*> elements;
+    std::vector<std::vector<size_t>> dependents;
+    std::unique_ptr<std::atomic<uint32_t>[]> num_dependencies;
+
+    absl::Mutex mutex;
+    absl::flat_hash_map<std::string, Element> element_by_document_name;
+    absl::flat_hash_map<std::string, merged_config_t*> merged_config_by_document_name;
+};
+
+void decrease_pending_elements(
+    context_t* ctx,
+    const std::shared_ptr<config_namespace_t>& cn,
+    const std::shared_ptr<pending_build_t>& pending_build
+);
+
+void schedule_build(
+    context_t* ctx,
+    const std::shared_ptr<config_namespace_t>& cn,
+    const std::shared_ptr<pending_build_t>& pending_build
+);
+
+class BuildElementCommand final : public WorkerCommand
+{
+public:
+    BuildElementCommand(
+        std::shared_ptr<build_dag_t> dag,
+        size_t idx
+    );
+
+    std::string name() const override;
+
+    bool force_take_metric() const override;
+
+    bool execute(
+        context_t* ctx
+    ) override;
+
+private:
+    std::shared_ptr<build_dag_t> dag_;
+    size_t idx_;
+
+    void build(
+        context_t* ctx,
+        build_element_t& be
+    );
+
+    template <typename M>
+    Element merge(
+        build_element_t& be,
+        const absl::flat_hash_map<std::string, Element>& element_by_document_name,
+        MultiPersistentLogger& logger
+    );
+
+    bool adopt_migrated_merged_config(
+        build_element_t& be,
+        ReplayLogger::Level log_level,
+        MultiPersistentLogger& logger,
+        Element& config
+    );
+
+    template <typename M>
+    void merge_raw_configs(
+        M& merger,
+        build_element_t& be,
+        const absl::flat_hash_map<std::string, Element>& element_by_document_name
+    );
+
+    void merge_raw_configs_by_key(
+        WarnElementMerger& merger,
+        document_t* document,
+        const std::vector<raw_config_t*>& raw_configs,
+        const absl::flat_hash_map<std::string, Element>& element_by_document_name
+    );
+
+    void merge_raw_configs_by_prefix(
+        WarnElementMerger& merger,
+        document_t* document,
+        const std::vector<raw_config_t*>& raw_configs
+    );
+};
+
+} /* worker */
+} /* mhconfig */
+
+#endif
@@ -0,0 +1,54 @@
+#include "mhconfig/worker/gc_string_pools_command.h"
+
+namespace mhconfig
+{
+namespace worker
+{
+
+GCStringPoolsCommand::GCStringPoolsCommand(
+  uint64_t time_budget_ms
+)
+  : time_budget_ms_(time_budget_ms)
+{
+}
+
+bool GCStringPoolsCommand::force_take_metric() const {
+  return true;
+}
+
+std::string GCStringPoolsCommand::name() const {
+  return "GC_STRING_POOLS";
+}
+
+bool GCStringPoolsCommand::execute(
+  context_t* ctx
+) {
+  auto deadline = jmutils::monotonic_now() + std::chrono::milliseconds(time_budget_ms_);
+
+  std::vector<std::shared_ptr<config_namespace_t>> cns;
+  ctx->mutex.ReaderLock();
+  cns.reserve(ctx->cn_by_root_path.size());
+  for (auto& it : ctx->cn_by_root_path) {
+    cns.push_back(it.second);
+  }
+  ctx->mutex.ReaderUnlock();
+
+  if (cns.empty()) return true;
+
+  // Every run continue with the namespace where the previous one stopped,
+  // so all of them are compacted although the time budget isn't enough
+  size_t start = ctx->gc_string_pools_cursor.load(std::memory_order_relaxed);
+  size_t i = 0;
+  for (size_t l = cns.size(); i < l; ++i) {
+    if (!gc_cn_string_pool(cns[(start + i) % l].get(), deadline)) break;
+  }
+  ctx->gc_string_pools_cursor.store(
+    (start + i) % cns.size(),
+    std::memory_order_relaxed
+  );
+
+  return true;
+}
+
+} /* worker */
+} /* mhconfig */
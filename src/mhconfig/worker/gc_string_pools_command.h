@@ -0,0 +1,41 @@
+#ifndef MHCONFIG__WORKER__GC_STRING_POOLS_COMMAND_H
+#define MHCONFIG__WORKER__GC_STRING_POOLS_COMMAND_H
+
+#include <bits/stdint-uintn.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "jmutils/time.h"
+#include "mhconfig/config_namespace.h"
+#include "mhconfig/context.h"
+#include "mhconfig/gc.h"
+
+namespace mhconfig
+{
+namespace worker
+{
+
+class GCStringPoolsCommand final : public WorkerCommand
+{
+public:
+  GCStringPoolsCommand(
+    uint64_t time_budget_ms
+  );
+
+  bool force_take_metric() const override;
+
+  std::string name() const override;
+
+  bool execute(
+    context_t* ctx
+  ) override;
+
+private:
+  uint64_t time_budget_ms_;
+};
+
+} /* worker */
+} /* mhconfig */
+
+#endif
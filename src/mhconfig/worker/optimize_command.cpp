@@ -35,6 +35,10 @@ bool OptimizeCommand::execute(
   merged_config_->mutex.Lock();
   merged_config_->checksum = std::move(checksum);
   bool ok = alloc_payload_locked(merged_config_.get());
+  merged_config_->status = ok
+    ? MergedConfigStatus::OPTIMIZED
+    : MergedConfigStatus::OPTIMIZATION_FAIL;
+  merged_config_->metrics = &context->metrics;
   std::swap(merged_config_->waiting, waiting);
   merged_config_->mutex.Unlock();
 
@@ -42,12 +46,11 @@ bool OptimizeCommand::execute(
     if (!ok) {
       waiting[i]->logger().error("Some error take place allocating the payload");
     }
-    waiting[i]->on_complete(
+    finish_successfully(
+      waiting[i].get(),
       cn_,
       0, //FIXME
-      merged_config_->value,
-      merged_config_->checksum,
-      merged_config_->payload
+      merged_config_.get()
     );
   }
 
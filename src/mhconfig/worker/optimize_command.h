@@ -7,6 +7,7 @@
 #include "mhconfig/builder.h"
 #include "mhconfig/config_namespace.h"
 #include "mhconfig/context.h"
+#include "mhconfig/provider.h"
 
 namespace mhconfig
 {
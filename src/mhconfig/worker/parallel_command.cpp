@@ -0,0 +1,78 @@
+#include "mhconfig/worker/parallel_command.h"
+
+namespace mhconfig
+{
+namespace worker
+{
+
+static void run_parallel_loop(parallel_loop_t* loop) {
+  for (
+    size_t i = loop->next_idx.fetch_add(1, std::memory_order_relaxed);
+    i < loop->size;
+    i = loop->next_idx.fetch_add(1, std::memory_order_relaxed)
+  ) {
+    bool ok = false;
+    try {
+      ok = loop->fn(i);
+    } catch (const std::exception &e) {
+      spdlog::error("Some error take place executing a parallel call: {}", e.what());
+    } catch (...) {
+      spdlog::error("Some unknown error take place executing a parallel call");
+    }
+
+    loop->mutex.Lock();
+    loop->ok = loop->ok && ok;
+    ++loop->num_done;
+    loop->mutex.Unlock();
+  }
+}
+
+ParallelCommand::ParallelCommand(
+  std::shared_ptr<parallel_loop_t> loop
+) : loop_(std::move(loop))
+{
+}
+
+ParallelCommand::~ParallelCommand() {
+}
+
+std::string ParallelCommand::name() const {
+  return "PARALLEL";
+}
+
+bool ParallelCommand::execute(
+  context_t* context
+) {
+  // The loop could be finished before this command is executed
+  run_parallel_loop(loop_.get());
+  return true;
+}
+
+bool parallel_for(
+  context_t* ctx,
+  size_t size,
+  size_t max_threads,
+  std::function<bool(size_t)>&& fn
+) {
+  auto loop = std::make_shared<parallel_loop_t>();
+  loop->fn = std::move(fn);
+  loop->size = size;
+
+  for (size_t i = 1, l = std::min(max_threads, size); i < l; ++i) {
+    ctx->worker_queue.push(std::make_unique<ParallelCommand>(loop));
+  }
+
+  run_parallel_loop(loop.get());
+
+  auto is_done = [](parallel_loop_t* loop) {
+    return loop->num_done == loop->size;
+  };
+  loop->mutex.LockWhen(absl::Condition(+is_done, loop.get()));
+  bool ok = loop->ok;
+  loop->mutex.Unlock();
+
+  return ok;
+}
+
+} /* worker */
+} /* mhconfig */
@@ -0,0 +1,60 @@
+#ifndef MHCONFIG__PARALLEL_COMMAND_H
+#define MHCONFIG__PARALLEL_COMMAND_H
+
+#include <absl/synchronization/mutex.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "mhconfig/config_namespace.h"
+
+namespace mhconfig
+{
+namespace worker
+{
+
+// The shared state of a loop whose iterations are run by the worker threads
+struct parallel_loop_t {
+  std::function<bool(size_t)> fn;
+  size_t size{0};
+  std::atomic<size_t> next_idx{0};
+
+  absl::Mutex mutex;
+  size_t num_done{0};
+  bool ok{true};
+};
+
+class ParallelCommand : public WorkerCommand
+{
+public:
+  ParallelCommand(
+    std::shared_ptr<parallel_loop_t> loop
+  );
+  virtual ~ParallelCommand();
+
+  std::string name() const override;
+
+  bool execute(
+    context_t* context
+  ) override;
+
+private:
+  std::shared_ptr<parallel_loop_t> loop_;
+};
+
+// Run the function for every index in [0, size) in the current thread and
+// in up to max_threads-1 worker threads, returning false if some call fail
+// or throw. The current thread only wait the calls that other threads have
+// already started, so it's never blocked by the queued commands
+bool parallel_for(
+  context_t* ctx,
+  size_t size,
+  size_t max_threads,
+  std::function<bool(size_t)>&& fn
+);
+
+} /* worker */
+} /* mhconfig */
+
+#endif
@@ -26,7 +26,7 @@ bool SetupCommand::execute(
   cn_->pool = std::make_shared<jmutils::string::Pool>(
     std::make_unique<string_pool::MetricsStatsObserver>(ctx->metrics, cn_->root_path)
   );
-  bool ok = init_config_namespace(cn_.get());
+  bool ok = init_config_namespace(ctx, cn_.get());
 
   if (ok) {
     std::vector<std::shared_ptr<GetConfigTask>> get_config_tasks_waiting;
@@ -62,7 +62,7 @@ bool UpdateCommand::process(
   api::request::UpdateRequest* request
 ) {
   files_to_update_t files_to_update;
-  if (!index_request_files(request, files_to_update)) {
+  if (!index_request_files(ctx, request, files_to_update)) {
     return false;
   }
 
@@ -128,6 +128,10 @@ bool UpdateCommand::process(
     }
 
     if (ok) {
+      // The merged configs used recently are built before publishing the
+      // version to avoid that the first requests and watchers wait for them
+      prewarm_merged_configs(ctx, obtain_hot_labels(dep_by_doc));
+
       spdlog::debug(
         "Updating the version of the config namespace '{}' to {}",
         cn_->root_path,
@@ -158,11 +162,13 @@ bool UpdateCommand::process(
 }
 
 bool UpdateCommand::index_request_files(
+  context_t* ctx,
   const api::request::UpdateRequest* request,
   files_to_update_t& files_to_update
 ) {
   if (request->reload()) {
     return index_files(
+      ctx,
       cn_->pool.get(),
       request->root_path(),
       [&files_to_update](auto&& labels, auto&& result) {
@@ -176,11 +182,22 @@ bool UpdateCommand::index_request_files(
   }
 
   std::filesystem::path root_path(request->root_path());
-  for (const auto& x : request->relative_paths()) {
-    std::filesystem::path relative_file_path(x);
-    auto path = root_path / relative_file_path;
-    auto result = index_file(cn_->pool.get(), root_path, path);
+  const auto& relative_paths = request->relative_paths();
+
+  std::vector<std::filesystem::path> paths;
+  paths.reserve(relative_paths.size());
+  for (const auto& x : relative_paths) {
+    paths.push_back(root_path / x);
+  }
+
+  std::vector<load_raw_config_result_t> results;
+  if (!index_files_in_parallel(ctx, cn_->pool.get(), root_path, paths, results)) {
+    return false;
+  }
+  for (size_t i = 0, l = results.size(); i < l; ++i) {
+    auto& result = results[i];
     if ((result.status == LoadRawConfigStatus::OK) || (result.status == LoadRawConfigStatus::FILE_DONT_EXISTS)) {
+      std::filesystem::path relative_file_path(relative_paths[i]);
       auto labels = get_path_labels(relative_file_path.parent_path());
       if (!labels) {
         return false;
@@ -405,6 +422,7 @@ bool UpdateCommand::update_documents(
         );
 
         override_->raw_config_by_version.emplace(cn_->current_version+1, nullptr);
+        document->overrides_versions.insert(cn_->current_version+1);
       } else {
         spdlog::debug(
           "Updating raw config (document: '{}', labels: {}, id: {})",
@@ -430,6 +448,7 @@ bool UpdateCommand::update_documents(
 
         document->raw_config_by_id[it.second.raw_config->id] = it.second.raw_config;
         override_->raw_config_by_version[cn_->current_version+1] = std::move(it.second.raw_config);
+        document->overrides_versions.insert(cn_->current_version+1);
       }
     }
     document->mutex.Unlock();
@@ -438,6 +457,140 @@ bool UpdateCommand::update_documents(
   return true;
 }
 
+std::vector<std::pair<std::string, Labels>> UpdateCommand::obtain_hot_labels(
+  const absl::flat_hash_map<std::string, absl::flat_hash_map<Labels, AffectedDocumentStatus>>& dep_by_doc
+) {
+  std::vector<std::tuple<uint64_t, std::string, Labels>> candidates;
+
+  auto now_s = jmutils::monotonic_now_sec();
+  auto timelimit_s = (now_s > PREWARM_MERGED_CONFIG_ACCESS_TIMELIMIT_S)
+    ? now_s - PREWARM_MERGED_CONFIG_ACCESS_TIMELIMIT_S
+    : 0;
+  for (const auto& it : dep_by_doc) {
+    auto document = get_document(cn_.get(), it.first, cn_->current_version);
+    if (document == nullptr) continue;
+
+    document->mutex.ReaderLock();
+    auto overrides_version = get_overrides_version_locked(
+      document.get(),
+      cn_->current_version
+    );
+    for (const auto& it2 : document->overrides_key_by_labels) {
+      if (it2.first.first < overrides_version) continue;
+
+      auto search = document->merged_config_by_overrides_key.find(it2.second);
+      if (search == document->merged_config_by_overrides_key.end()) continue;
+
+      auto merged_config = search->second.lock();
+      if (merged_config == nullptr) continue;
+
+      // This will have read-write race conditions but this should not be a problem
+      uint64_t last_access_timestamp = merged_config->last_access_timestamp;
+      if (last_access_timestamp > timelimit_s) {
+        candidates.emplace_back(last_access_timestamp, it.first, it2.first.second);
+      }
+    }
+    document->mutex.ReaderUnlock();
+  }
+
+  if (candidates.size() > MAX_PREWARMED_MERGED_CONFIGS) {
+    std::nth_element(
+      candidates.begin(),
+      candidates.begin() + MAX_PREWARMED_MERGED_CONFIGS,
+      candidates.end(),
+      [](const auto& a, const auto& b) { return std::get<0>(a) > std::get<0>(b); }
+    );
+    candidates.resize(MAX_PREWARMED_MERGED_CONFIGS);
+  }
+
+  std::vector<std::pair<std::string, Labels>> result;
+  result.reserve(candidates.size());
+  for (auto& it : candidates) {
+    result.emplace_back(std::move(std::get<1>(it)), std::move(std::get<2>(it)));
+  }
+
+  return result;
+}
+
+void UpdateCommand::prewarm_merged_configs(
+  context_t* ctx,
+  std::vector<std::pair<std::string, Labels>>&& hot_labels
+) {
+  if (hot_labels.empty()) return;
+
+  spdlog::debug(
+    "Prewarming {} merged configs of the config namespace '{}'",
+    hot_labels.size(),
+    cn_->root_path
+  );
+
+  // The tasks are counted before running them to avoid a premature wake up
+  auto counter = std::make_shared<prewarm_counter_t>();
+  std::vector<std::shared_ptr<GetConfigTask>> tasks;
+  tasks.reserve(hot_labels.size());
+  for (auto& it : hot_labels) {
+    tasks.push_back(
+      std::make_shared<PrewarmGetConfigTask>(
+        cn_->current_version+1,
+        std::move(it.second),
+        std::string(cn_->root_path),
+        std::move(it.first),
+        counter
+      )
+    );
+  }
+
+  auto deadline = jmutils::monotonic_now()
+    + std::chrono::milliseconds(PREWARM_MERGED_CONFIGS_TIMEOUT_MS);
+
+  // This thread prewarms the configs too, so the update isn't blocked
+  // if it's the only worker or the rest are busy. The tasks that aren't
+  // started before the deadline are released without prewarm
+  worker::parallel_for(
+    ctx,
+    tasks.size(),
+    std::max(std::thread::hardware_concurrency(), 1u),
+    [this, ctx, &tasks, deadline](size_t i) {
+      if (jmutils::monotonic_now() < deadline) {
+        process_prewarm_config_task(
+          decltype(cn_)(cn_),
+          std::move(tasks[i]),
+          ctx
+        );
+      } else {
+        tasks[i].reset();
+      }
+      return true;
+    }
+  );
+  tasks.clear();
+
+  // Some builds could finish in other workers (e.g. the referenced
+  // documents), so they are waited until the deadline
+  auto now = jmutils::monotonic_now();
+  auto timeout_ms = now < deadline
+    ? std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count()
+    : 0;
+  auto is_done = [](prewarm_counter_t* counter) {
+    return counter->num_pending == 0;
+  };
+  counter->mutex.LockWhenWithTimeout(
+    absl::Condition(+is_done, counter.get()),
+    absl::Milliseconds(timeout_ms)
+  );
+  uint32_t num_pending = counter->num_pending;
+  counter->mutex.Unlock();
+
+  if (num_pending != 0) {
+    spdlog::warn(
+      "Publishing the version {} of the config namespace '{}' with {} merged configs without prewarm",
+      cn_->current_version+1,
+      cn_->root_path,
+      num_pending
+    );
+  }
+}
+
 void UpdateCommand::trigger_watchers(
   context_t* ctx,
   const absl::flat_hash_map<std::string, absl::flat_hash_map<Labels, AffectedDocumentStatus>>& dep_by_doc
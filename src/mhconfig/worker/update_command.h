@@ -4,6 +4,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "jmutils/container/label_set.h"
@@ -13,6 +14,7 @@
 #include "mhconfig/config_namespace.h"
 #include "mhconfig/context.h"
 #include "mhconfig/provider.h"
+#include "mhconfig/worker/parallel_command.h"
 #include "mhconfig/worker/setup_command.h"
 
 namespace mhconfig
@@ -51,6 +53,7 @@ private:
   );
 
   bool index_request_files(
+    context_t* ctx,
     const api::request::UpdateRequest* request,
     files_to_update_t& files_to_update
   );
@@ -71,6 +74,15 @@ private:
     files_to_update_t& files_to_update
   );
 
+  std::vector<std::pair<std::string, Labels>> obtain_hot_labels(
+    const absl::flat_hash_map<std::string, absl::flat_hash_map<Labels, AffectedDocumentStatus>>& dep_by_doc
+  );
+
+  void prewarm_merged_configs(
+    context_t* ctx,
+    std::vector<std::pair<std::string, Labels>>&& hot_labels
+  );
+
   void trigger_watchers(
     context_t* ctx,
     const absl::flat_hash_map<std::string, absl::flat_hash_map<Labels, AffectedDocumentStatus>>& dep_by_doc
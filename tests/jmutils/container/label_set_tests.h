@@ -155,6 +155,36 @@ TEST_CASE("Label set", "[label-set]") {
     }
   }
 
+  SECTION("Test subset after remove") {
+    LabelSet<uint64_t> lbl_set;
+
+    auto labels_1 = make_labels({{"key1", "value_1"}});
+    auto labels_2 = make_labels({{"key1", "value_1"}, {"key2", "value_2"}});
+
+    lbl_set.insert(EMPTY_LABELS, 1);
+    lbl_set.insert(labels_1, 2);
+    lbl_set.insert(labels_2, 3);
+
+    REQUIRE(lbl_set.remove(labels_2));
+    REQUIRE(*lbl_set.get(labels_1) == 2);
+
+    auto labels = make_labels(
+      {{"key1", "value_1"}, {"key2", "value_2"}, {"unknown", "xxx"}}
+    );
+    absl::flat_hash_map<Labels, uint64_t> seen;
+    bool ok = lbl_set.for_each_subset(
+      labels,
+      [&seen](const auto& l, auto* v) {
+        seen[l] = *v;
+        return true;
+      }
+    );
+    REQUIRE(ok);
+    REQUIRE(seen.size() == 2);
+    REQUIRE(seen[EMPTY_LABELS] == 1);
+    REQUIRE(seen[labels_1] == 2);
+  }
+
 }
 
 }
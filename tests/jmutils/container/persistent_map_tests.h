@@ -0,0 +1,176 @@
+#ifndef JMUTILS__CONTAINER__PERSISTENT_MAP_TESTS_H
+#define JMUTILS__CONTAINER__PERSISTENT_MAP_TESTS_H
+
+#include <catch2/catch.hpp>
+
+#include <map>
+
+#include "jmutils/container/persistent_map.h"
+
+namespace jmutils {
+namespace container {
+
+// Only a few bits to force the collisions in the last level
+struct colliding_hash_t {
+  size_t operator()(uint64_t key) const {
+    return key & 3;
+  }
+};
+
+template <typename T>
+void require_same_values(
+  const T& map,
+  const std::map<uint64_t, uint64_t>& expected
+) {
+  REQUIRE(map.size() == expected.size());
+  std::map<uint64_t, uint64_t> values;
+  for (const auto& it : map) {
+    REQUIRE(values.emplace(it.first, it.second).second);
+  }
+  REQUIRE(values == expected);
+  for (const auto& it : expected) {
+    auto search = map.find(it.first);
+    REQUIRE(search != map.end());
+    REQUIRE(search->second == it.second);
+  }
+}
+
+TEST_CASE("Persistent map", "[persistent-map]") {
+  // The metadata counts the values of the subtree
+  auto count_values = [](auto values, auto children, size_t& metadata) {
+    metadata = values.size();
+    for (const auto* child : children) {
+      metadata += *child;
+    }
+  };
+
+  SECTION("Insert, find and erase the keys") {
+    PersistentMap<uint64_t, uint64_t> map;
+    std::map<uint64_t, uint64_t> expected;
+    for (uint64_t i = 0; i < 10000; ++i) {
+      map[i*7] = i;
+      expected[i*7] = i;
+    }
+    REQUIRE(!map.emplace(7, 0));
+    require_same_values(map, expected);
+    REQUIRE(map.find(1) == map.end());
+
+    for (uint64_t i = 0; i < 10000; i += 3) {
+      REQUIRE(map.erase(i*7) == 1);
+      expected.erase(i*7);
+    }
+    REQUIRE(map.erase(1) == 0);
+    require_same_values(map, expected);
+
+    for (auto& it : map) {
+      it.second += 1;
+      expected[it.first] += 1;
+    }
+    require_same_values(map, expected);
+
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE(map.begin() == map.end());
+  }
+
+  SECTION("Store the colliding keys") {
+    PersistentMap<uint64_t, uint64_t, no_metadata_t, colliding_hash_t> map;
+    std::map<uint64_t, uint64_t> expected;
+    for (uint64_t i = 0; i < 100; ++i) {
+      REQUIRE(map.emplace(i, i*2));
+      expected[i] = i*2;
+    }
+    require_same_values(map, expected);
+
+    for (uint64_t i = 0; i < 100; i += 2) {
+      REQUIRE(map.erase(i) == 1);
+      expected.erase(i);
+    }
+    require_same_values(map, expected);
+
+    for (uint64_t i = 1; i < 100; i += 2) {
+      map.erase(map.find(i));
+    }
+    REQUIRE(map.empty());
+  }
+
+  SECTION("The modifications of a copy don't change the original") {
+    PersistentMap<uint64_t, uint64_t> map;
+    std::map<uint64_t, uint64_t> expected;
+    for (uint64_t i = 0; i < 5000; ++i) {
+      map[i] = i;
+      expected[i] = i;
+    }
+
+    auto copy = map;
+    auto expected_copy = expected;
+    for (uint64_t i = 0; i < 5000; i += 10) {
+      copy.find(i)->second = 0;
+      expected_copy[i] = 0;
+      copy.erase(i+1);
+      expected_copy.erase(i+1);
+      copy[i+5000] = i;
+      expected_copy[i+5000] = i;
+    }
+
+    require_same_values(map, expected);
+    require_same_values(copy, expected_copy);
+  }
+
+  SECTION("Freeze only the modified paths") {
+    PersistentMap<uint64_t, uint64_t, size_t> map;
+    for (uint64_t i = 0; i < 50000; ++i) {
+      map[i] = i;
+    }
+    REQUIRE(map.freeze(count_values) == 50000);
+    REQUIRE(map.make_metadata(count_values) == 50000);
+
+    auto copy = map;
+    copy[50000] = 0;
+    copy.erase(0);
+    copy.find(1)->second = 2;
+
+    size_t num_calls = 0;
+    auto counted = [&num_calls, &count_values](auto values, auto children, size_t& metadata) {
+      ++num_calls;
+      count_values(values, children, metadata);
+    };
+    REQUIRE(copy.make_metadata(counted) == 50000);
+    REQUIRE(copy.freeze(counted) == 50000);
+    REQUIRE(num_calls <= 2*3*4);
+
+    num_calls = 0;
+    REQUIRE(copy.freeze(counted) == 50000);
+    REQUIRE(map.freeze(counted) == 50000);
+    REQUIRE(num_calls == 0);
+  }
+
+  SECTION("Skip the frozen nodes") {
+    PersistentMap<uint64_t, uint64_t, size_t> map;
+    for (uint64_t i = 0; i < 1000; ++i) {
+      map[i] = i;
+    }
+    map.freeze(count_values);
+    map[1000] = 1000;
+
+    size_t num_values = 0;
+    map.for_each(
+      [](size_t) { return false; },
+      [&num_values](const auto&) { ++num_values; }
+    );
+    REQUIRE(num_values == 1001);
+
+    std::vector<uint64_t> keys;
+    map.for_each(
+      [](size_t) { return true; },
+      [&keys](const auto& it) { keys.push_back(it.first); }
+    );
+    REQUIRE(keys.size() < 100);
+    REQUIRE(std::find(keys.begin(), keys.end(), 1000) != keys.end());
+  }
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef JMUTILS__CONTAINER__PERSISTENT_VECTOR_TESTS_H
+#define JMUTILS__CONTAINER__PERSISTENT_VECTOR_TESTS_H
+
+#include <catch2/catch.hpp>
+
+#include "jmutils/container/persistent_vector.h"
+
+namespace jmutils {
+namespace container {
+
+template <typename T>
+void require_same_values(
+  const T& vector,
+  const std::vector<uint64_t>& expected
+) {
+  REQUIRE(vector.size() == expected.size());
+  size_t i = 0;
+  for (const auto& x : vector) {
+    REQUIRE(x == expected[i]);
+    REQUIRE(vector[i] == expected[i]);
+    ++i;
+  }
+  REQUIRE(i == expected.size());
+}
+
+TEST_CASE("Persistent vector", "[persistent-vector]") {
+  // The metadata is the sum of the values of the subtree
+  auto sum_values = [](auto values, auto children, uint64_t& metadata) {
+    metadata = 0;
+    for (const auto& x : values) {
+      metadata += x;
+    }
+    for (const auto* child : children) {
+      metadata += *child;
+    }
+  };
+
+  SECTION("Push, read and modify the values") {
+    PersistentVector<uint64_t> vector;
+    std::vector<uint64_t> expected;
+    // Enough values for three levels of nodes
+    for (uint64_t i = 0; i < 40000; ++i) {
+      vector.push_back(i);
+      expected.push_back(i);
+    }
+    require_same_values(vector, expected);
+    REQUIRE(vector.front() == 0);
+    REQUIRE(vector.back() == 39999);
+
+    for (auto& x : vector) {
+      x *= 2;
+    }
+    for (auto& x : expected) {
+      x *= 2;
+    }
+    vector[1234] = 1;
+    expected[1234] = 1;
+    require_same_values(vector, expected);
+
+    vector.clear();
+    REQUIRE(vector.empty());
+    REQUIRE(vector.begin() == vector.end());
+  }
+
+  SECTION("The modifications of a copy don't change the original") {
+    PersistentVector<uint64_t> vector;
+    std::vector<uint64_t> expected;
+    for (uint64_t i = 0; i < 3000; ++i) {
+      vector.push_back(i);
+      expected.push_back(i);
+    }
+
+    auto copy = vector;
+    auto expected_copy = expected;
+    for (uint64_t i = 0; i < 3000; ++i) {
+      copy.push_back(i);
+      expected_copy.push_back(i);
+    }
+    copy[7] = 0;
+    expected_copy[7] = 0;
+
+    require_same_values(vector, expected);
+    require_same_values(copy, expected_copy);
+  }
+
+  SECTION("Freeze only the modified paths") {
+    PersistentVector<uint64_t, uint64_t> vector;
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < 50000; ++i) {
+      vector.push_back(i);
+      sum += i;
+    }
+    REQUIRE(vector.freeze(sum_values) == sum);
+
+    auto copy = vector;
+    copy.push_back(10);
+    copy[5] = 0;
+
+    size_t num_calls = 0;
+    auto counted = [&num_calls, &sum_values](auto values, auto children, uint64_t& metadata) {
+      ++num_calls;
+      sum_values(values, children, metadata);
+    };
+    REQUIRE(copy.make_metadata(counted) == sum + 10 - 5);
+    REQUIRE(copy.freeze(counted) == sum + 10 - 5);
+    REQUIRE(num_calls <= 2*(2*4+1));
+
+    num_calls = 0;
+    REQUIRE(vector.freeze(counted) == sum);
+    REQUIRE(num_calls == 1);
+  }
+
+  SECTION("Skip the frozen nodes") {
+    PersistentVector<uint64_t, uint64_t> vector;
+    for (uint64_t i = 0; i < 1000; ++i) {
+      vector.push_back(i);
+    }
+    vector.freeze(sum_values);
+    vector[500] = 0;
+
+    std::vector<size_t> idxs;
+    vector.for_each(
+      [](uint64_t) { return true; },
+      [&idxs, &vector](size_t idx, uint64_t x) {
+        REQUIRE(vector[idx] == x);
+        idxs.push_back(idx);
+      }
+    );
+    REQUIRE(idxs.size() == 32);
+    REQUIRE(idxs.front() == 480);
+
+    size_t num_values = 0;
+    vector.for_each(
+      [](uint64_t) { return false; },
+      [&num_values](size_t, uint64_t) { ++num_values; }
+    );
+    REQUIRE(num_values == 1000);
+  }
+}
+
+}
+}
+
+#endif
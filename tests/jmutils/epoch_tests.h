@@ -0,0 +1,51 @@
+#ifndef JMUTILS__EPOCH_TESTS_H
+#define JMUTILS__EPOCH_TESTS_H
+
+#include <catch2/catch.hpp>
+
+#include "jmutils/epoch.h"
+
+namespace jmutils {
+namespace epoch {
+
+void release_counter(void* data) {
+  *static_cast<size_t*>(data) += 1;
+}
+
+TEST_CASE("Epoch", "[epoch]") {
+  SECTION("Retire without readers") {
+    size_t released = 0;
+    retire(&released, &release_counter);
+    REQUIRE(released == 1);
+  }
+
+  SECTION("Retire with a reader") {
+    size_t released = 0;
+    {
+      Guard guard;
+      {
+        Guard nested_guard;
+      }
+      retire(&released, &release_counter);
+      REQUIRE(released == 0);
+    }
+    reclaim();
+    REQUIRE(released == 1);
+  }
+
+  SECTION("The new readers don't block the retired data") {
+    size_t released = 0;
+    {
+      Guard guard;
+      retire(&released, &release_counter);
+    }
+    Guard guard;
+    reclaim();
+    REQUIRE(released == 1);
+  }
+}
+
+}
+}
+
+#endif
@@ -8,6 +8,37 @@
 namespace jmutils {
 namespace string {
 
+// Make strings of 10000 characters stored in the same shard of the pool,
+// in that way the number of chunks doesn't depend on the hash of them
+std::vector<std::string> make_strings_of_a_shard(size_t n) {
+  std::vector<std::string> result;
+  for (size_t i = 0; result.size() < n; ++i) {
+    std::string s(10000, '\0');
+    s[i] = 'x';
+    if ((std::hash<std::string>{}(s) & (POOL_NUM_SHARDS-1)) == 0) {
+      result.push_back(std::move(s));
+    }
+  }
+  return result;
+}
+
+class AccumulatorStatsObserver final : public StatsObserver
+{
+public:
+  explicit AccumulatorStatsObserver(stats_delta_t& stats) : stats_(stats) {
+  }
+
+  void on_updated_stats(const stats_delta_t& delta, bool force) override {
+    stats_.num_strings += delta.num_strings;
+    stats_.num_chunks += delta.num_chunks;
+    stats_.reclaimed_bytes += delta.reclaimed_bytes;
+    stats_.used_bytes += delta.used_bytes;
+  }
+
+private:
+  stats_delta_t& stats_;
+};
+
 TEST_CASE("String", "[string]") {
   SECTION("Small string from std::string") {
     InternalString internal_string;
@@ -71,6 +102,35 @@ TEST_CASE("String", "[string]") {
     REQUIRE(s.is_small() == false);
   }
 
+  SECTION("Compare small strings with std::string") {
+    for (const std::string str : {"", "a", "hello", "1234567", "remembered", "12345678"}) {
+      InternalString internal_string;
+      String s = make_string(str, &internal_string);
+      REQUIRE(s.is_small() == true);
+      REQUIRE(s == str);
+      REQUIRE(str == s);
+      REQUIRE(s != str + "x");
+      REQUIRE(str + "x" != s);
+      REQUIRE(s != "h.llo");
+    }
+  }
+
+  SECTION("Copy a string to a buffer") {
+    for (const std::string str : {"", "hello", "remembered", "not a small string"}) {
+      InternalString internal_string;
+      String s = make_string(str, &internal_string);
+      char buffer[32];
+      auto [ptr, ec] = s.to_chars(buffer, buffer + sizeof(buffer));
+      REQUIRE(ec == std::errc());
+      REQUIRE(std::string(buffer, ptr) == str);
+
+      if (!str.empty()) {
+        auto [ptr, ec] = s.to_chars(buffer, buffer + str.size() - 1);
+        REQUIRE(ec == std::errc::value_too_large);
+      }
+    }
+  }
+
   SECTION("Small string from std::string in utf8") {
     InternalString internal_string;
     String s = make_string("¬¬", &internal_string);
@@ -99,6 +159,82 @@ TEST_CASE("String pool", "[string-pool]") {
     REQUIRE(pool.stats().num_strings == 1);
   }
 
+  SECTION("Add and release large strings") {
+    Pool pool;
+    std::string large(CHUNK_DATA_SIZE*3, 'x');
+    large[CHUNK_DATA_SIZE*2] = 'y';
+    {
+      auto s = pool.add(large);
+      REQUIRE(s == large);
+      REQUIRE(s.str() == large);
+      REQUIRE(pool.add(large) == s);
+      REQUIRE(pool.stats().num_strings == 1);
+      REQUIRE(pool.stats().num_chunks == 0);
+      REQUIRE(pool.stats().used_bytes == large.size());
+    }
+    REQUIRE(pool.stats().num_strings == 0);
+    REQUIRE(pool.stats().used_bytes == 0);
+  }
+
+  SECTION("Release the strings that outlive the pool") {
+    std::string large(CHUNK_DATA_SIZE, 'x');
+    std::string lorem = "Lorem ipsum dolor sit amet, consetetur sadipscing elitr, sed diam nonumy eirmod tempor invidunt ut labore et dolore magna aliquyam erat, sed diam voluptua. At vero eos et accusam et justo duo dolores et ea rebum. Stet clita kasd gubergren, no sea takimata sanctus est Lorem ipsum dolor sit amet.";
+    String large_string;
+    String lorem_string;
+    {
+      Pool pool;
+      large_string = pool.add(large);
+      lorem_string = pool.add(lorem);
+      pool.add(std::string(CHUNK_DATA_SIZE, 'y'));
+    }
+    REQUIRE(large_string == large);
+    REQUIRE(lorem_string == lorem);
+  }
+
+  SECTION("Add a batch of strings") {
+    Pool pool;
+    std::string lorem = "Lorem ipsum dolor sit amet, consetetur sadipscing elitr, sed diam nonumy eirmod tempor invidunt ut labore et dolore magna aliquyam erat, sed diam voluptua. At vero eos et accusam et justo duo dolores et ea rebum. Stet clita kasd gubergren, no sea takimata sanctus est Lorem ipsum dolor sit amet.";
+    auto s = pool.add(lorem);
+
+    std::vector<std::string> strs;
+    for (size_t i = 0; i < 100; ++i) {
+      strs.push_back(fmt::format("string number {}", i % 50));
+    }
+    strs.push_back("world");
+    strs.push_back(lorem);
+
+    std::vector<String> result;
+    pool.add(strs, result);
+    REQUIRE(result.size() == strs.size());
+    for (size_t i = 0, l = strs.size(); i < l; ++i) {
+      REQUIRE(result[i] == strs[i]);
+      REQUIRE(result[i] == pool.add(strs[i]));
+    }
+    REQUIRE(result.back() == s);
+    REQUIRE(pool.stats().num_strings == 51);
+  }
+
+  SECTION("Copy the characters of the strings") {
+    Pool pool;
+    std::string lorem = "Lorem ipsum dolor sit amet, consetetur sadipscing elitr, sed diam nonumy eirmod tempor invidunt ut labore et dolore magna aliquyam erat, sed diam voluptua. At vero eos et accusam et justo duo dolores et ea rebum. Stet clita kasd gubergren, no sea takimata sanctus est Lorem ipsum dolor sit amet.";
+    for (const auto& str : {std::string(), std::string("world"), std::string("remembered"), lorem}) {
+      auto s = pool.add(str);
+      std::string result(s.size(), '\0');
+      s.copy(result.data());
+      REQUIRE(result == str);
+    }
+  }
+
+  SECTION("Pin the characters of the strings") {
+    Pool pool;
+    std::string large(CHUNK_DATA_SIZE, 'x');
+    for (const auto& str : {std::string(), std::string("world"), std::string("remembered"), std::string("not a small string"), large}) {
+      auto s = pool.add(str);
+      PinnedString pinned(s);
+      REQUIRE(pinned.view() == str);
+    }
+  }
+
   SECTION("Add multiple times the same string") {
     Pool pool;
     std::string lorem = "Lorem ipsum dolor sit amet, consetetur sadipscing elitr, sed diam nonumy eirmod tempor invidunt ut labore et dolore magna aliquyam erat, sed diam voluptua. At vero eos et accusam et justo duo dolores et ea rebum. Stet clita kasd gubergren, no sea takimata sanctus est Lorem ipsum dolor sit amet.";
@@ -110,13 +246,25 @@ TEST_CASE("String pool", "[string-pool]") {
     REQUIRE(pool.stats().num_chunks == 1);
   }
 
+  SECTION("Add a string rendered in place") {
+    Pool pool;
+    std::string lorem = "Lorem ipsum dolor sit amet, consetetur sadipscing elitr";
+    String expected = pool.add(lorem);
+    String small = pool.add(5, [](char* output) { memcpy(output, "hello", 5); });
+    String large = pool.add(lorem.size(), [&lorem](char* output) { lorem.copy(output, lorem.size()); });
+    REQUIRE(small == "hello");
+    REQUIRE(small.is_small() == true);
+    REQUIRE(large == lorem);
+    REQUIRE(large == expected);
+    REQUIRE(pool.stats().num_strings == 1);
+  }
+
   SECTION("Automatic chunk cleanup after string removal") {
     Pool pool;
+    auto strs = make_strings_of_a_shard(150);
     std::vector<String> strings;
-    for (size_t i = 0; i < 150; ++i) {
-      std::string s(10000, '\0');
-      s[i] = 'x';
-      strings.push_back(pool.add(s));
+    for (const auto& str : strs) {
+      strings.push_back(pool.add(str));
     }
     REQUIRE(pool.stats().num_strings == 150);
     REQUIRE(pool.stats().num_chunks == 25);
@@ -129,11 +277,10 @@ TEST_CASE("String pool", "[string-pool]") {
 
   SECTION("Force pool compaction") {
     Pool pool;
+    auto strs = make_strings_of_a_shard(150);
     std::vector<String> strings;
-    for (size_t i = 0; i < 150; ++i) {
-      std::string s(10000, '\0');
-      s[i] = 'x';
-      strings.push_back(pool.add(s));
+    for (const auto& str : strs) {
+      strings.push_back(pool.add(str));
     }
     REQUIRE(pool.stats().num_strings == 150);
     REQUIRE(pool.stats().num_chunks == 25);
@@ -144,15 +291,64 @@ TEST_CASE("String pool", "[string-pool]") {
     REQUIRE(pool.stats().num_strings == 0);
     REQUIRE(pool.stats().num_chunks == 25);
 
-    for (size_t i = 0; i < 150; ++i) {
-      std::string s(10000, '\0');
-      s[i] = 'x';
-      strings.push_back(pool.add(s));
+    for (const auto& str : strs) {
+      strings.push_back(pool.add(str));
     }
     REQUIRE(pool.stats().num_strings == 150);
     REQUIRE(pool.stats().num_chunks == 25);
   }
 
+  SECTION("Report the changes of the stats") {
+    stats_delta_t stats;
+    {
+      Pool pool(std::make_unique<AccumulatorStatsObserver>(stats));
+      auto strs = make_strings_of_a_shard(150);
+      strs.push_back(std::string(CHUNK_DATA_SIZE, 'x'));
+      std::vector<String> strings;
+      for (const auto& str : strs) {
+        strings.push_back(pool.add(str));
+      }
+      REQUIRE(stats.num_strings == 151);
+      REQUIRE(stats.num_chunks == 25);
+      REQUIRE(stats.used_bytes == 150*10000 + CHUNK_DATA_SIZE);
+
+      strings.resize(6);
+      REQUIRE(pool.compact(monotonic_now() + std::chrono::seconds(60)));
+      REQUIRE(stats.num_strings == (int64_t) pool.stats().num_strings);
+      REQUIRE(stats.num_chunks == 2);
+      REQUIRE(stats.reclaimed_bytes == (int64_t) pool.stats().reclaimed_bytes);
+      REQUIRE(pool.stats().used_bytes == 6*10000);
+      REQUIRE(stats.used_bytes == 6*10000);
+    }
+    REQUIRE(stats.num_strings == 0);
+    REQUIRE(stats.num_chunks == 0);
+    REQUIRE(stats.reclaimed_bytes == 0);
+    REQUIRE(stats.used_bytes == 0);
+  }
+
+  SECTION("Incremental pool compaction") {
+    Pool pool;
+    auto strs = make_strings_of_a_shard(150);
+    std::vector<String> strings;
+    for (const auto& str : strs) {
+      strings.push_back(pool.add(str));
+    }
+    REQUIRE(pool.stats().num_chunks == 25);
+
+    strings.resize(6);
+    REQUIRE(pool.compact(monotonic_now()) == false);
+    REQUIRE(pool.stats().num_chunks == 25);
+
+    REQUIRE(pool.compact(monotonic_now() + std::chrono::seconds(60)));
+
+    // Only the chunk with the strings and the current one are kept
+    REQUIRE(pool.stats().num_strings == 6);
+    REQUIRE(pool.stats().num_chunks == 2);
+    for (size_t i = 0; i < 6; ++i) {
+      REQUIRE(strings[i] == strs[i]);
+    }
+  }
+
 }
 
 }
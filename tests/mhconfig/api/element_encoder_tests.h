@@ -0,0 +1,348 @@
+#ifndef MHCONFIG__API__ELEMENT_ENCODER_TESTS_H
+#define MHCONFIG__API__ELEMENT_ENCODER_TESTS_H
+
+#include <catch2/catch.hpp>
+
+#include "jmutils/string/pool.h"
+#include "mhconfig/api/element_encoder.h"
+#include "mhconfig/api/response_encoder.h"
+
+namespace mhconfig {
+namespace api {
+
+// Fill the elements with the protobuf API, the encoder must produce the same
+// serialization
+template <typename T>
+uint32_t fill_elements(
+  const Element& root,
+  T* container,
+  proto::Element* output,
+  bool with_position,
+  SourceIds& source_ids
+) {
+  if (with_position && (root.document_id() != 0xffff) && (root.raw_config_id() != 0xffff)) {
+    source_ids.emplace(root.document_id(), root.raw_config_id());
+    auto position = output->mutable_position();
+    auto id = make_source_id(root.document_id(), root.raw_config_id());
+    position->set_present(true);
+    position->set_source_id(id);
+    position->set_line(root.line());
+    position->set_col(root.col());
+  }
+
+  switch (root.type()) {
+    case Element::Type::UNDEFINED: {
+      output->set_value_type(proto::Element_ValueType_UNDEFINED);
+      return 1;
+    }
+
+    case Element::Type::NONE: {
+      output->set_value_type(proto::Element_ValueType_NONE);
+      return 1;
+    }
+
+    case Element::Type::STR: {
+      if (auto r = root.try_as<Literal>(); r) {
+        jmutils::string::PinnedString value(*r);
+        output->set_value_type(proto::Element_ValueType_STR);
+        output->set_value_str(value.data(), value.size());
+      } else {
+        output->set_value_type(proto::Element_ValueType_UNDEFINED);
+      }
+      return 1;
+    }
+
+    case Element::Type::BIN: {
+      if (auto r = root.try_as<Literal>(); r) {
+        jmutils::string::PinnedString value(*r);
+        output->set_value_type(proto::Element_ValueType_BIN);
+        output->set_value_bin(value.data(), value.size());
+      } else {
+        output->set_value_type(proto::Element_ValueType_UNDEFINED);
+      }
+      return 1;
+    }
+
+    case Element::Type::INT64: {
+      if (auto r = root.try_as<int64_t>(); r) {
+        output->set_value_type(proto::Element_ValueType_INT64);
+        output->set_value_int(*r);
+      } else {
+        output->set_value_type(proto::Element_ValueType_UNDEFINED);
+      }
+      return 1;
+    }
+
+    case Element::Type::DOUBLE: {
+      if (auto r = root.try_as<double>(); r) {
+        output->set_value_type(proto::Element_ValueType_DOUBLE);
+        output->set_value_double(*r);
+      } else {
+        output->set_value_type(proto::Element_ValueType_UNDEFINED);
+      }
+      return 1;
+    }
+
+    case Element::Type::BOOL: {
+      if (auto r = root.try_as<bool>(); r) {
+        output->set_value_type(proto::Element_ValueType_BOOL);
+        output->set_value_bool(*r);
+      } else {
+        output->set_value_type(proto::Element_ValueType_UNDEFINED);
+      }
+      return 1;
+    }
+
+    case Element::Type::MAP: {
+      output->set_value_type(proto::Element_ValueType_MAP);
+      auto map = root.as_map();
+      output->set_size(map->size());
+
+      uint32_t parent_sibling_offset = 1;
+      ::mhconfig::proto::Element* value = output;
+      for (const auto& it : *map) {
+        value = container->add_elements();
+
+        uint32_t sibling_offset = fill_elements(
+          it.second,
+          container,
+          value,
+          with_position,
+          source_ids
+        );
+        value->set_key_type(proto::Element_KeyType_KSTR);
+        jmutils::string::PinnedString key(it.first);
+        value->set_key_str(key.data(), key.size());
+        value->set_sibling_offset(sibling_offset-1);
+
+        parent_sibling_offset += sibling_offset;
+      }
+      value->set_sibling_offset(0);
+
+      return parent_sibling_offset;
+    }
+
+    case Element::Type::SEQUENCE: {
+      output->set_value_type(proto::Element_ValueType_SEQUENCE);
+      auto seq = root.as_seq();
+      output->set_size(seq->size());
+
+      uint32_t parent_sibling_offset = 1;
+      ::mhconfig::proto::Element* value = output;
+      for (size_t i = 0, l = seq->size(); i < l; ++i) {
+        value = container->add_elements();
+
+        uint32_t sibling_offset = fill_elements(
+          (*seq)[i],
+          container,
+          value,
+          with_position,
+          source_ids
+        );
+        value->set_sibling_offset(sibling_offset-1);
+
+        parent_sibling_offset += sibling_offset;
+      }
+      value->set_sibling_offset(0);
+
+      return parent_sibling_offset;
+    }
+  }
+
+  output->set_value_type(proto::Element_ValueType_UNDEFINED);
+  return 1;
+}
+
+inline void require_same_encoding(const Element& root, bool with_position) {
+  proto::GetResponse response;
+  SourceIds expected_source_ids;
+  fill_elements(
+    root,
+    &response,
+    response.add_elements(),
+    with_position,
+    expected_source_ids
+  );
+
+  auto encoded = encode_elements(
+    root,
+    proto::GetResponse::kElementsFieldNumber,
+    with_position
+  );
+
+  REQUIRE(encoded->data == response.SerializeAsString());
+  REQUIRE(encoded->source_ids == expected_source_ids);
+}
+
+inline Element with_source(Element element, int line, int col) {
+  element.set_document_id(1);
+  element.set_raw_config_id(2);
+  element.set_position(line, col);
+  return element;
+}
+
+TEST_CASE("Element encoder", "[element-encoder]") {
+  jmutils::string::Pool pool;
+
+  SECTION("Encode the literals") {
+    std::string large(300, 'x');
+    for (const auto& element : {
+      Element(),
+      Element(Element::Type::NONE),
+      Element(pool.add("hello")),
+      Element(pool.add(large)),
+      Element(pool.add(""), Element::Type::BIN),
+      Element(pool.add("\x01\x02"), Element::Type::BIN),
+      Element((int64_t) 0),
+      Element((int64_t) -1234567890123),
+      Element((int64_t) 99),
+      Element(3.25),
+      Element(true),
+      Element(false),
+    }) {
+      require_same_encoding(element, false);
+      require_same_encoding(element, true);
+    }
+  }
+
+  SECTION("Encode the empty containers") {
+    require_same_encoding(Element(Map()), false);
+    require_same_encoding(Element(Seq()), false);
+  }
+
+  SECTION("Encode the nested maps and sequences") {
+    Seq seq;
+    seq.push_back(Element((int64_t) 1));
+    seq.push_back(Element(Map()));
+    seq.push_back(Element(pool.add("two")));
+
+    Map inner;
+    inner[pool.add("seq")] = Element(std::move(seq));
+    inner[pool.add("empty")] = Element(Seq());
+
+    Map map;
+    map[pool.add("inner")] = Element(std::move(inner));
+    map[pool.add("flag")] = Element(true);
+    map[pool.add(std::string(200, 'k'))] = Element(Element::Type::NONE);
+
+    Element root(std::move(map));
+    require_same_encoding(root, false);
+
+    root.freeze();
+    require_same_encoding(root, false);
+  }
+
+  SECTION("Encode the positions") {
+    Seq seq;
+    seq.push_back(with_source(Element((int64_t) 7), 3, 5));
+    seq.push_back(Element(2.5));
+
+    Map map;
+    map[pool.add("seq")] = with_source(Element(std::move(seq)), 2, 0);
+    map[pool.add("str")] = with_source(Element(pool.add("value")), 0, 9);
+
+    auto root = with_source(Element(std::move(map)), 1, 1);
+    root.set_document_id(3);
+
+    require_same_encoding(root, true);
+    require_same_encoding(root, false);
+
+    auto encoded = encode_elements(
+      root,
+      proto::GetResponse::kElementsFieldNumber,
+      true
+    );
+    REQUIRE(encoded->source_ids == SourceIds({{3, 2}, {1, 2}}));
+  }
+
+  SECTION("Append the elements to the response buffer") {
+    Map map;
+    map[pool.add("key")] = Element(pool.add("value"));
+    auto encoded = encode_elements(
+      Element(std::move(map)),
+      proto::WatchResponse::kElementsFieldNumber,
+      false
+    );
+
+    proto::WatchResponse message;
+    message.set_uid(3);
+    message.set_namespace_id(1234);
+    message.set_version(5);
+    message.set_checksum("checksum");
+
+    auto buffer = make_response_buffer(message, encoded, nullptr);
+    encoded.reset();
+
+    std::vector<grpc::Slice> slices;
+    REQUIRE(buffer.Dump(&slices).ok());
+    std::string data;
+    for (const auto& slice : slices) {
+      data.append((const char*) slice.begin(), slice.size());
+    }
+
+    proto::WatchResponse response;
+    REQUIRE(response.ParseFromString(data));
+    REQUIRE(response.uid() == 3);
+    REQUIRE(response.namespace_id() == 1234);
+    REQUIRE(response.version() == 5);
+    REQUIRE(response.checksum() == "checksum");
+    REQUIRE(response.elements_size() == 2);
+    REQUIRE(response.elements(0).value_type() == proto::Element_ValueType_MAP);
+    REQUIRE(response.elements(1).key_str() == "key");
+    REQUIRE(response.elements(1).value_str() == "value");
+  }
+
+  SECTION("Append the encoded logs to the response buffer") {
+    LogsEncoder encoder(ResponseType::WATCH);
+    encoder.add_log(LogLevel::WARN, "first");
+    encoder.add_log(
+      LogLevel::ERROR,
+      "second",
+      position_t{.source_id = 7, .line = 2, .col = 3}
+    );
+    encoder.set_sources({source_t{
+      .document_id = 0,
+      .raw_config_id = 7,
+      .checksum = 42,
+      .path = "a.yaml"
+    }});
+
+    auto logs = std::make_shared<encoded_logs_t>();
+    logs->data = encoder.encode();
+
+    proto::WatchResponse message;
+    message.set_uid(3);
+    auto log = message.add_logs();
+    log->set_level(proto::LogLevel::DEBUG);
+    log->set_message("zero");
+
+    auto buffer = make_response_buffer(message, nullptr, logs);
+    logs.reset();
+
+    std::vector<grpc::Slice> slices;
+    REQUIRE(buffer.Dump(&slices).ok());
+    std::string data;
+    for (const auto& slice : slices) {
+      data.append((const char*) slice.begin(), slice.size());
+    }
+
+    proto::WatchResponse response;
+    REQUIRE(response.ParseFromString(data));
+    REQUIRE(response.uid() == 3);
+    REQUIRE(response.logs_size() == 3);
+    REQUIRE(response.logs(0).message() == "zero");
+    REQUIRE(response.logs(1).message() == "first");
+    REQUIRE(response.logs(1).level() == proto::LogLevel::WARN);
+    REQUIRE(response.logs(2).message() == "second");
+    REQUIRE(response.logs(2).position().source_id() == 7);
+    REQUIRE(response.logs(2).position().line() == 2);
+    REQUIRE(response.sources_size() == 1);
+    REQUIRE(response.sources(0).checksum() == 42);
+    REQUIRE(response.sources(0).path() == "a.yaml");
+  }
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef MHCONFIG__LOGGER__PERSISTENT_LOGGER_TESTS_H
+#define MHCONFIG__LOGGER__PERSISTENT_LOGGER_TESTS_H
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+#include "jmutils/string/pool.h"
+#include "mhconfig/logger/multi_persistent_logger.h"
+#include "mhconfig/logger/persistent_logger.h"
+
+#define define_recorder_logger_method(LEVEL) \
+  void LEVEL( \
+    const char* message \
+  ) override { \
+    logs.push_back(fmt::format(#LEVEL " {}", message)); \
+  } \
+\
+  void LEVEL( \
+    const char* message, \
+    const Element& element \
+  ) override { \
+    logs.push_back( \
+      fmt::format( \
+        #LEVEL " {} {}:{}", \
+        message, \
+        element.document_id(), \
+        element.raw_config_id() \
+      ) \
+    ); \
+  } \
+\
+  void LEVEL( \
+    const char* message, \
+    const Element& element, \
+    const Element& origin \
+  ) override { \
+    logs.push_back( \
+      fmt::format( \
+        #LEVEL " {} {}:{} {}:{}", \
+        message, \
+        element.document_id(), \
+        element.raw_config_id(), \
+        origin.document_id(), \
+        origin.raw_config_id() \
+      ) \
+    ); \
+  }
+
+namespace mhconfig {
+namespace logger {
+
+// Keep the replayed logs with the ids of their positions
+class RecorderLogger final : public Logger
+{
+public:
+  define_recorder_logger_method(error)
+  define_recorder_logger_method(warn)
+  define_recorder_logger_method(debug)
+  define_recorder_logger_method(trace)
+
+  std::vector<std::string> logs;
+};
+
+inline Element make_positioned_element(DocumentId document_id, RawConfigId raw_config_id) {
+  Element element;
+  element.set_document_id(document_id);
+  element.set_raw_config_id(raw_config_id);
+  return element;
+}
+
+TEST_CASE("Persistent logger", "[persistent-logger]") {
+  jmutils::string::Pool pool;
+
+  SECTION("Clone changing the document") {
+    MultiPersistentLogger logger;
+    logger.warn("static", make_positioned_element(1, 2));
+    logger.error(pool.add("dynamic"), make_positioned_element(1, 3), make_positioned_element(4, 2));
+    logger.trace("unchanged", make_positioned_element(1, 9));
+    for (size_t i = 0; i < 2*LOGGER_CHUNK_SIZE; ++i) {
+      logger.debug(pool.add(fmt::format("dynamic {}", i)), make_positioned_element(1, 2));
+    }
+    logger.freeze();
+
+    RecorderLogger expected;
+    logger.replay(expected);
+
+    auto clone = logger.clone_changing_document(1, 5, {{2, 0}, {3, 1}});
+
+    RecorderLogger original;
+    logger.replay(original);
+    REQUIRE(original.logs == expected.logs);
+
+    RecorderLogger cloned;
+    clone->replay(cloned);
+    REQUIRE(cloned.logs.size() == expected.logs.size());
+    REQUIRE(cloned.logs[0] == "warn static 5:0");
+    REQUIRE(cloned.logs[1] == "error dynamic 5:1 4:2");
+    REQUIRE(cloned.logs[2] == "trace unchanged 1:9");
+    for (size_t i = 0; i < 2*LOGGER_CHUNK_SIZE; ++i) {
+      REQUIRE(cloned.logs[3+i] == fmt::format("debug dynamic {} 5:0", i));
+    }
+
+    RecorderLogger warn_logs;
+    clone->replay(warn_logs, ReplayLogger::Level::warn);
+    REQUIRE(warn_logs.logs == std::vector<std::string>({"warn static 5:0", "error dynamic 5:1 4:2"}));
+  }
+}
+
+}
+}
+
+#endif
@@ -2,5 +2,10 @@
 #include <catch2/catch.hpp>
 
 #include "jmutils/container/label_set_tests.h"
+#include "jmutils/container/persistent_map_tests.h"
+#include "jmutils/container/persistent_vector_tests.h"
+#include "jmutils/epoch_tests.h"
 #include "jmutils/string/pool_tests.h"
+#include "mhconfig/api/element_encoder_tests.h"
 #include "mhconfig/auth/path_acl_tests.h"
+#include "mhconfig/logger/persistent_logger_tests.h"